@@ -136,7 +136,7 @@ static int64_t decode_error_stat[2];
 
 static int want_sdp = 1;
 
-static int current_time;
+static int64_t current_time;
 AVIOContext *progress_avio = NULL;
 
 static uint8_t *subtitle_out;
@@ -163,6 +163,7 @@ static int restore_tty;
 
 #if HAVE_PTHREADS
 static void free_input_threads(void);
+static int free_encoder_threads(int drain);
 #endif
 
 /* sub2video hack:
@@ -472,6 +473,22 @@ static void ffmpeg_cleanup(int ret)
         av_log(NULL, AV_LOG_INFO, "bench: maxrss=%ikB\n", maxrss);
     }
 
+    if (do_benchmark_all) {
+        for (i = 0; i < nb_output_streams; i++) {
+            OutputFilter *ofilter = output_streams[i]->filter;
+            if (!ofilter)
+                continue;
+            av_log(NULL, AV_LOG_INFO, "bench: stream %d:%d: %"PRIu64" frames "
+                   "forwarded by reference, %"PRIu64" frames from the filtergraph\n",
+                   output_streams[i]->file_index, output_streams[i]->index,
+                   ofilter->nb_frames_forwarded, ofilter->nb_frames_filtered);
+        }
+    }
+
+#if HAVE_PTHREADS
+    free_encoder_threads(0);
+#endif
+
     for (i = 0; i < nb_filtergraphs; i++) {
         FilterGraph *fg = filtergraphs[i];
         avfilter_graph_free(&fg->graph);
@@ -498,6 +515,15 @@ static void ffmpeg_cleanup(int ret)
         }
         av_freep(&fg->inputs);
         for (j = 0; j < fg->nb_outputs; j++) {
+            if (fg->outputs[j]->frame_queue) {
+                while (av_fifo_size(fg->outputs[j]->frame_queue)) {
+                    AVFrame *frame;
+                    av_fifo_generic_read(fg->outputs[j]->frame_queue, &frame,
+                                         sizeof(frame), NULL);
+                    av_frame_free(&frame);
+                }
+                av_fifo_freep(&fg->outputs[j]->frame_queue);
+            }
             av_freep(&fg->outputs[j]->name);
             av_freep(&fg->outputs[j]->formats);
             av_freep(&fg->outputs[j]->channel_layouts);
@@ -599,6 +625,7 @@ static void ffmpeg_cleanup(int ret)
                    av_err2str(AVERROR(errno)));
     }
     av_freep(&vstats_filename);
+    av_freep(&filter_thread_type);
 
     av_freep(&input_streams);
     av_freep(&input_files);
@@ -642,21 +669,79 @@ static void abort_codec_experimental(AVCodec *c, int encoder)
     exit_program(1);
 }
 
-static void update_benchmark(const char *fmt, ...)
+static void vupdate_benchmark(int64_t *last_time, const char *fmt, va_list va)
 {
     if (do_benchmark_all) {
         int64_t t = getutime();
-        va_list va;
         char buf[1024];
 
         if (fmt) {
-            va_start(va, fmt);
             vsnprintf(buf, sizeof(buf), fmt, va);
-            va_end(va);
-            av_log(NULL, AV_LOG_INFO, "bench: %8"PRIu64" %s \n", t - current_time, buf);
+            av_log(NULL, AV_LOG_INFO, "bench: %8"PRIu64" %s \n", t - *last_time, buf);
         }
-        current_time = t;
+        *last_time = t;
+    }
+}
+
+static void update_benchmark(const char *fmt, ...)
+{
+    va_list va;
+
+    va_start(va, fmt);
+    vupdate_benchmark(&current_time, fmt, va);
+    va_end(va);
+}
+
+/* encoder threads time their encoder calls separately from the main thread */
+static void update_encoder_benchmark(OutputStream *ost, const char *fmt, ...)
+{
+    va_list va;
+
+    va_start(va, fmt);
+#if HAVE_PTHREADS
+    if (ost->enc_thread_queue)
+        vupdate_benchmark(&ost->enc_bench_time, fmt, va);
+    else
+#endif
+        vupdate_benchmark(&current_time, fmt, va);
+    va_end(va);
+}
+
+#if HAVE_PTHREADS
+/* serializes access to the muxers when encoders run in their own threads */
+static pthread_mutex_t mux_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void lock_muxer(void)
+{
+#if HAVE_PTHREADS
+    pthread_mutex_lock(&mux_lock);
+#endif
+}
+
+static void unlock_muxer(void)
+{
+#if HAVE_PTHREADS
+    pthread_mutex_unlock(&mux_lock);
+#endif
+}
+
+/**
+ * Give up on a fatal muxing error; must be called with the muxer lock held.
+ * Encoder threads must not exit the program, they stop with the error
+ * instead and the main thread exits once it notices.
+ */
+static void muxing_failed(OutputStream *ost, int err)
+{
+#if HAVE_PTHREADS
+    if (ost->enc_thread_queue && pthread_equal(ost->enc_thread, pthread_self())) {
+        ost->enc_thread_ret = err;
+        return;
     }
+#endif
+    /* the encoder threads are joined on exit, do not keep them waiting */
+    unlock_muxer();
+    exit_program(1);
 }
 
 static void close_all_output_streams(OutputStream *ost, OSTFinished this_stream, OSTFinished others)
@@ -700,15 +785,16 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
                 av_log(NULL, AV_LOG_ERROR,
                        "Too many packets buffered for output stream %d:%d.\n",
                        ost->file_index, ost->st->index);
-                exit_program(1);
+                ret = AVERROR(ENOSPC);
+                goto fail;
             }
             ret = av_fifo_realloc2(ost->muxing_queue, new_size);
             if (ret < 0)
-                exit_program(1);
+                goto fail;
         }
         ret = av_packet_ref(&tmp_pkt, pkt);
         if (ret < 0)
-            exit_program(1);
+            goto fail;
         av_fifo_generic_write(ost->muxing_queue, &tmp_pkt, sizeof(tmp_pkt), NULL);
         av_packet_unref(pkt);
         return;
@@ -766,7 +852,8 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
                        ost->file_index, ost->st->index, ost->last_mux_dts, pkt->dts);
                 if (exit_on_error) {
                     av_log(NULL, AV_LOG_FATAL, "aborting.\n");
-                    exit_program(1);
+                    ret = AVERROR(EINVAL);
+                    goto fail;
                 }
                 av_log(s, loglevel, "changing to %"PRId64". This may result "
                        "in incorrect timestamps in the output file.\n",
@@ -801,6 +888,10 @@ static void write_packet(OutputFile *of, AVPacket *pkt, OutputStream *ost, int u
         close_all_output_streams(ost, MUXER_FINISHED | ENCODER_FINISHED, ENCODER_FINISHED);
     }
     av_packet_unref(pkt);
+    return;
+fail:
+    av_packet_unref(pkt);
+    muxing_failed(ost, ret);
 }
 
 static void close_output_stream(OutputStream *ost)
@@ -854,7 +945,7 @@ finish:
         av_log(NULL, AV_LOG_ERROR, "Error applying bitstream filters to an output "
                "packet for stream #%d:%d.\n", ost->file_index, ost->index);
         if(exit_on_error)
-            exit_program(1);
+            muxing_failed(ost, ret);
     }
 }
 
@@ -871,64 +962,222 @@ static int check_recording_time(OutputStream *ost)
     return 1;
 }
 
-static void do_audio_out(OutputFile *of, OutputStream *ost,
-                         AVFrame *frame)
+/**
+ * Send a frame to the encoder of ost and write out all the packets the
+ * encoder returns.
+ *
+ * @return size of the last packet written, or a negative error code
+ */
+static int encode_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
 {
     AVCodecContext *enc = ost->enc_ctx;
+    const char *type = av_get_media_type_string(enc->codec_type);
     AVPacket pkt;
-    int ret;
+    int ret, frame_size = 0;
 
     av_init_packet(&pkt);
     pkt.data = NULL;
     pkt.size = 0;
 
-    if (!check_recording_time(ost))
-        return;
-
-    if (frame->pts == AV_NOPTS_VALUE || audio_sync_method < 0)
-        frame->pts = ost->sync_opts;
-    ost->sync_opts = frame->pts + frame->nb_samples;
-    ost->samples_encoded += frame->nb_samples;
-    ost->frames_encoded++;
-
-    av_assert0(pkt.size || !pkt.data);
-    update_benchmark(NULL);
-    if (debug_ts) {
-        av_log(NULL, AV_LOG_INFO, "encoder <- type:audio "
-               "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
-               av_ts2str(frame->pts), av_ts2timestr(frame->pts, &enc->time_base),
-               enc->time_base.num, enc->time_base.den);
-    }
+    update_encoder_benchmark(ost, NULL);
 
     ret = avcodec_send_frame(enc, frame);
     if (ret < 0)
-        goto error;
+        return ret;
 
     while (1) {
         ret = avcodec_receive_packet(enc, &pkt);
         if (ret == AVERROR(EAGAIN))
             break;
         if (ret < 0)
-            goto error;
-
-        update_benchmark("encode_audio %d.%d", ost->file_index, ost->index);
+            return ret;
 
-        av_packet_rescale_ts(&pkt, enc->time_base, ost->mux_timebase);
+        update_encoder_benchmark(ost, "encode_%s %d.%d", type, ost->file_index, ost->index);
 
         if (debug_ts) {
-            av_log(NULL, AV_LOG_INFO, "encoder -> type:audio "
+            av_log(NULL, AV_LOG_INFO, "encoder -> type:%s "
                    "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
+                   type,
                    av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &enc->time_base),
                    av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &enc->time_base));
         }
 
+        if (enc->codec_type == AVMEDIA_TYPE_VIDEO &&
+            pkt.pts == AV_NOPTS_VALUE && !(enc->codec->capabilities & AV_CODEC_CAP_DELAY))
+            pkt.pts = frame->pts;
+
+        /* mux_timebase may still change until the header has been written */
+        lock_muxer();
+        av_packet_rescale_ts(&pkt, enc->time_base, ost->mux_timebase);
+
+        if (debug_ts && enc->codec_type == AVMEDIA_TYPE_VIDEO) {
+            av_log(NULL, AV_LOG_INFO, "encoder -> type:video "
+                "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
+                av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &ost->mux_timebase),
+                av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &ost->mux_timebase));
+        }
+
+        frame_size = pkt.size;
         output_packet(of, &pkt, ost);
+        unlock_muxer();
+#if HAVE_PTHREADS
+        if (ost->enc_thread_ret < 0)
+            return ost->enc_thread_ret;
+#endif
+
+        /* if two pass, output log */
+        if (ost->logfile && enc->stats_out) {
+            fprintf(ost->logfile, "%s", enc->stats_out);
+        }
     }
 
-    return;
-error:
-    av_log(NULL, AV_LOG_FATAL, "Audio encoding failed\n");
-    exit_program(1);
+    return frame_size;
+}
+
+#if HAVE_PTHREADS
+static void free_frame_msg(void *msg)
+{
+    av_frame_free(msg);
+}
+
+static void *encoder_thread(void *arg)
+{
+    OutputStream *ost = arg;
+    OutputFile    *of = output_files[ost->file_index];
+    AVFrame *frame;
+    int ret;
+
+    while ((ret = av_thread_message_queue_recv(ost->enc_thread_queue, &frame, 0)) >= 0) {
+        ret = encode_frame(of, ost, frame);
+        av_frame_free(&frame);
+        if (ret < 0)
+            break;
+        if (vstats_filename && ret && ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+            lock_muxer();
+            do_video_stats(ost, ret);
+            unlock_muxer();
+        }
+    }
+
+    if (ret == AVERROR_EOF)
+        ret = 0;
+    else if (ret < 0)
+        av_log(NULL, AV_LOG_ERROR, "Error encoding output stream #%d:%d: %s\n",
+               ost->file_index, ost->index, av_err2str(ret));
+    ost->enc_thread_ret = ret;
+    av_thread_message_queue_set_err_send(ost->enc_thread_queue,
+                                         ret < 0 ? ret : AVERROR_EOF);
+    return NULL;
+}
+
+static int init_encoder_thread(OutputStream *ost)
+{
+    int ret;
+
+    /* do_video_stats() cannot exit the program from the encoder thread */
+    if (vstats_filename && !vstats_file &&
+        ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+        vstats_file = fopen(vstats_filename, "w");
+        if (!vstats_file)
+            return AVERROR(errno);
+    }
+
+    ret = av_thread_message_queue_alloc(&ost->enc_thread_queue,
+                                        enc_thread_queue_size, sizeof(AVFrame *));
+    if (ret < 0)
+        return ret;
+    av_thread_message_queue_set_free_func(ost->enc_thread_queue, free_frame_msg);
+
+    if ((ret = pthread_create(&ost->enc_thread, NULL, encoder_thread, ost))) {
+        av_log(NULL, AV_LOG_ERROR, "pthread_create failed: %s. Try to increase `ulimit -v` or decrease `ulimit -s`.\n", strerror(ret));
+        av_thread_message_queue_free(&ost->enc_thread_queue);
+        return AVERROR(ret);
+    }
+    return 0;
+}
+
+/**
+ * Stop all encoder threads, handing the encoders back to the main thread.
+ *
+ * @param drain encode the frames still queued instead of discarding them
+ * @return 0 on success, the first encoding error otherwise
+ */
+static int free_encoder_threads(int drain)
+{
+    int i, ret = 0;
+
+    for (i = 0; i < nb_output_streams; i++) {
+        OutputStream *ost = output_streams[i];
+
+        if (!ost || !ost->enc_thread_queue)
+            continue;
+        if (!drain)
+            av_thread_message_flush(ost->enc_thread_queue);
+        av_thread_message_queue_set_err_recv(ost->enc_thread_queue, AVERROR_EOF);
+
+        pthread_join(ost->enc_thread, NULL);
+        av_thread_message_flush(ost->enc_thread_queue);
+        av_thread_message_queue_free(&ost->enc_thread_queue);
+        if (ost->enc_thread_ret < 0 && !ret)
+            ret = ost->enc_thread_ret;
+    }
+    return ret;
+}
+#endif
+
+/**
+ * Hand a frame over to the encoder of ost, either directly or through its
+ * encoder thread.
+ *
+ * @return size of the last packet written when encoding synchronously,
+ *         0 when the frame was queued, or a negative error code
+ */
+static int submit_frame(OutputFile *of, OutputStream *ost, AVFrame *frame)
+{
+#if HAVE_PTHREADS
+    if (ost->enc_thread_queue) {
+        AVFrame *queued = av_frame_clone(frame);
+        int ret;
+
+        if (!queued)
+            return AVERROR(ENOMEM);
+        ret = av_thread_message_queue_send(ost->enc_thread_queue, &queued, 0);
+        if (ret < 0) {
+            av_frame_free(&queued);
+            av_log(NULL, AV_LOG_ERROR, "Encoder thread for stream %d:%d failed: %s\n",
+                   ost->file_index, ost->index, av_err2str(ret));
+        }
+        return ret < 0 ? ret : 0;
+    }
+#endif
+    return encode_frame(of, ost, frame);
+}
+
+static void do_audio_out(OutputFile *of, OutputStream *ost,
+                         AVFrame *frame)
+{
+    AVCodecContext *enc = ost->enc_ctx;
+
+    if (!check_recording_time(ost))
+        return;
+
+    if (frame->pts == AV_NOPTS_VALUE || audio_sync_method < 0)
+        frame->pts = ost->sync_opts;
+    ost->sync_opts = frame->pts + frame->nb_samples;
+    ost->samples_encoded += frame->nb_samples;
+    ost->frames_encoded++;
+
+    if (debug_ts) {
+        av_log(NULL, AV_LOG_INFO, "encoder <- type:audio "
+               "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
+               av_ts2str(frame->pts), av_ts2timestr(frame->pts, &enc->time_base),
+               enc->time_base.num, enc->time_base.den);
+    }
+
+    if (submit_frame(of, ost, frame) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Audio encoding failed\n");
+        exit_program(1);
+    }
 }
 
 static void do_subtitle_out(OutputFile *of,
@@ -1010,7 +1259,9 @@ static void do_subtitle_out(OutputFile *of,
                 pkt.pts += av_rescale_q(sub->end_display_time, (AVRational){ 1, 1000 }, ost->mux_timebase);
         }
         pkt.dts = pkt.pts;
+        lock_muxer();
         output_packet(of, &pkt, ost);
+        unlock_muxer();
     }
 }
 
@@ -1019,7 +1270,7 @@ static void do_video_out(OutputFile *of,
                          AVFrame *next_picture,
                          double sync_ipts)
 {
-    int ret, format_video_sync;
+    int format_video_sync;
     AVPacket pkt;
     AVCodecContext *enc = ost->enc_ctx;
     AVCodecParameters *mux_par = ost->st->codecpar;
@@ -1196,7 +1447,9 @@ static void do_video_out(OutputFile *of,
         pkt.pts    = av_rescale_q(in_picture->pts, enc->time_base, ost->mux_timebase);
         pkt.flags |= AV_PKT_FLAG_KEY;
 
+        lock_muxer();
         output_packet(of, &pkt, ost);
+        unlock_muxer();
     } else
 #endif
     {
@@ -1257,7 +1510,6 @@ static void do_video_out(OutputFile *of,
             av_log(NULL, AV_LOG_DEBUG, "Forced keyframe at time %f\n", pts_time);
         }
 
-        update_benchmark(NULL);
         if (debug_ts) {
             av_log(NULL, AV_LOG_INFO, "encoder <- type:video "
                    "frame_pts:%s frame_pts_time:%s time_base:%d/%d\n",
@@ -1267,45 +1519,9 @@ static void do_video_out(OutputFile *of,
 
         ost->frames_encoded++;
 
-        ret = avcodec_send_frame(enc, in_picture);
-        if (ret < 0)
+        frame_size = submit_frame(of, ost, in_picture);
+        if (frame_size < 0)
             goto error;
-
-        while (1) {
-            ret = avcodec_receive_packet(enc, &pkt);
-            update_benchmark("encode_video %d.%d", ost->file_index, ost->index);
-            if (ret == AVERROR(EAGAIN))
-                break;
-            if (ret < 0)
-                goto error;
-
-            if (debug_ts) {
-                av_log(NULL, AV_LOG_INFO, "encoder -> type:video "
-                       "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
-                       av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &enc->time_base),
-                       av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &enc->time_base));
-            }
-
-            if (pkt.pts == AV_NOPTS_VALUE && !(enc->codec->capabilities & AV_CODEC_CAP_DELAY))
-                pkt.pts = ost->sync_opts;
-
-            av_packet_rescale_ts(&pkt, enc->time_base, ost->mux_timebase);
-
-            if (debug_ts) {
-                av_log(NULL, AV_LOG_INFO, "encoder -> type:video "
-                    "pkt_pts:%s pkt_pts_time:%s pkt_dts:%s pkt_dts_time:%s\n",
-                    av_ts2str(pkt.pts), av_ts2timestr(pkt.pts, &ost->mux_timebase),
-                    av_ts2str(pkt.dts), av_ts2timestr(pkt.dts, &ost->mux_timebase));
-            }
-
-            frame_size = pkt.size;
-            output_packet(of, &pkt, ost);
-
-            /* if two pass, output log */
-            if (ost->logfile && enc->stats_out) {
-                fprintf(ost->logfile, "%s", enc->stats_out);
-            }
-        }
     }
     ost->sync_opts++;
     /*
@@ -1396,6 +1612,29 @@ static void finish_output_stream(OutputStream *ost)
     }
 }
 
+/**
+ * Get the next frame of an output filter, taking the frames forwarded around
+ * a pass-through graph before the ones returned by the buffer sink.
+ */
+static int ofilter_get_frame(OutputFilter *ofilter, AVFrame *frame)
+{
+    int ret;
+
+    if (ofilter->frame_queue && av_fifo_size(ofilter->frame_queue)) {
+        AVFrame *tmp;
+        av_fifo_generic_read(ofilter->frame_queue, &tmp, sizeof(tmp), NULL);
+        av_frame_move_ref(frame, tmp);
+        av_frame_free(&tmp);
+        return 0;
+    }
+
+    ret = av_buffersink_get_frame_flags(ofilter->filter, frame,
+                                        AV_BUFFERSINK_FLAG_NO_REQUEST);
+    if (ret >= 0)
+        ofilter->nb_frames_filtered++;
+    return ret;
+}
+
 /**
  * Get and encode new output from any of the filtergraphs, without causing
  * activity.
@@ -1436,8 +1675,7 @@ static int reap_filters(int flush)
 
         while (1) {
             double float_pts = AV_NOPTS_VALUE; // this is identical to filtered_frame.pts but with higher precision
-            ret = av_buffersink_get_frame_flags(filter, filtered_frame,
-                                               AV_BUFFERSINK_FLAG_NO_REQUEST);
+            ret = ofilter_get_frame(ost->filter, filtered_frame);
             if (ret < 0) {
                 if (ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
                     av_log(NULL, AV_LOG_WARNING,
@@ -1661,6 +1899,8 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
 
     oc = output_files[0]->ctx;
 
+    /* the encoder threads update the muxers and the stream statistics */
+    lock_muxer();
     total_size = avio_size(oc->pb);
     if (total_size <= 0) // FIXME improve avio_size() so it works with non seekable output too
         total_size = avio_tell(oc->pb);
@@ -1740,6 +1980,7 @@ static void print_report(int is_last_report, int64_t timer_start, int64_t cur_ti
         if (is_last_report)
             nb_frames_drop += ost->last_dropped;
     }
+    unlock_muxer();
 
     secs = FFABS(pts) / AV_TIME_BASE;
     us = FFABS(pts) % AV_TIME_BASE;
@@ -1938,7 +2179,9 @@ static void flush_encoders(void)
                 }
                 av_packet_rescale_ts(&pkt, enc->time_base, ost->mux_timebase);
                 pkt_size = pkt.size;
+                lock_muxer();
                 output_packet(of, &pkt, ost);
+                unlock_muxer();
                 if (ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO && vstats_filename) {
                     do_video_stats(ost, pkt_size);
                 }
@@ -2077,7 +2320,9 @@ static void do_streamcopy(InputStream *ist, OutputStream *ost, const AVPacket *p
     }
 #endif
 
+    lock_muxer();
     output_packet(of, &opkt, ost);
+    unlock_muxer();
 }
 
 int guess_input_channel_layout(InputStream *ist)
@@ -2194,6 +2439,9 @@ static int ifilter_send_frame(InputFilter *ifilter, AVFrame *frame)
         }
     }
 
+    if (fg->passthrough)
+        return ofilter_forward_frame(fg->outputs[0], frame);
+
     ret = av_buffersrc_add_frame_flags(ifilter->filter, frame, AV_BUFFERSRC_FLAG_PUSH);
     if (ret < 0) {
         if (ret != AVERROR_EOF)
@@ -3587,9 +3835,24 @@ static int init_output_stream(OutputStream *ost, char *error, int error_len)
     if (ret < 0)
         return ret;
 
+#if HAVE_PTHREADS
+    if (enc_thread_queue_size > 0 && ost->encoding_needed &&
+        (ost->enc_ctx->codec_type == AVMEDIA_TYPE_VIDEO ||
+         ost->enc_ctx->codec_type == AVMEDIA_TYPE_AUDIO)) {
+        ret = init_encoder_thread(ost);
+        if (ret < 0) {
+            snprintf(error, error_len, "Error starting encoder thread for "
+                     "output stream #%d:%d", ost->file_index, ost->index);
+            return ret;
+        }
+    }
+#endif
+
     ost->initialized = 1;
 
+    lock_muxer();
     ret = check_init_output_file(output_files[ost->file_index], ost->file_index);
+    unlock_muxer();
     if (ret < 0)
         return ret;
 
@@ -3786,8 +4049,9 @@ static int transcode_init(void)
 /* Return 1 if there remain streams where more output is wanted, 0 otherwise. */
 static int need_output(void)
 {
-    int i;
+    int i, ret = 0;
 
+    lock_muxer();
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost    = output_streams[i];
         OutputFile *of       = output_files[ost->file_index];
@@ -3803,10 +4067,12 @@ static int need_output(void)
             continue;
         }
 
-        return 1;
+        ret = 1;
+        break;
     }
+    unlock_muxer();
 
-    return 0;
+    return ret;
 }
 
 /**
@@ -3820,6 +4086,7 @@ static OutputStream *choose_output(void)
     int64_t opts_min = INT64_MAX;
     OutputStream *ost_min = NULL;
 
+    lock_muxer();
     for (i = 0; i < nb_output_streams; i++) {
         OutputStream *ost = output_streams[i];
         int64_t opts = ost->st->cur_dts == AV_NOPTS_VALUE ? INT64_MIN :
@@ -3828,14 +4095,17 @@ static OutputStream *choose_output(void)
         if (ost->st->cur_dts == AV_NOPTS_VALUE)
             av_log(NULL, AV_LOG_DEBUG, "cur_dts is invalid (this is harmless if it occurs once at the start per stream)\n");
 
-        if (!ost->initialized && !ost->inputs_done)
-            return ost;
+        if (!ost->initialized && !ost->inputs_done) {
+            ost_min = ost;
+            break;
+        }
 
         if (!ost->finished && opts < opts_min) {
             opts_min = opts;
             ost_min  = ost->unavailable ? NULL : ost;
         }
     }
+    unlock_muxer();
     return ost_min;
 }
 
@@ -4611,6 +4881,12 @@ static int transcode(void)
             process_input_packet(ist, NULL, 0);
         }
     }
+#if HAVE_PTHREADS
+    if (free_encoder_threads(1) < 0) {
+        av_log(NULL, AV_LOG_FATAL, "Encoding failed\n");
+        exit_program(1);
+    }
+#endif
     flush_encoders();
 
     term_exit();
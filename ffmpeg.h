@@ -283,6 +283,12 @@ typedef struct OutputFilter {
     int *formats;
     uint64_t *channel_layouts;
     int *sample_rates;
+
+    /* frames forwarded by reference around a pass-through graph */
+    AVFifoBuffer *frame_queue;
+
+    uint64_t nb_frames_forwarded;
+    uint64_t nb_frames_filtered;
 } OutputFilter;
 
 typedef struct FilterGraph {
@@ -291,6 +297,7 @@ typedef struct FilterGraph {
 
     AVFilterGraph *graph;
     int reconfiguration;
+    int passthrough;    ///< the graph does not modify its frames and is bypassed
 
     InputFilter   **inputs;
     int          nb_inputs;
@@ -557,6 +564,13 @@ typedef struct OutputStream {
 
     /* frame encode sum of squared error values */
     int64_t error[4];
+
+#if HAVE_PTHREADS
+    AVThreadMessageQueue *enc_thread_queue;
+    pthread_t enc_thread;       /* thread running the encoder of this stream */
+    int enc_thread_ret;         /* error the encoder thread stopped with, if any */
+    int64_t enc_bench_time;     /* -benchmark_all timer of the encoder thread */
+#endif
 } OutputStream;
 
 typedef struct OutputFile {
@@ -617,6 +631,8 @@ extern char *videotoolbox_pixfmt;
 
 extern int filter_nbthreads;
 extern int filter_complex_nbthreads;
+extern char *filter_thread_type;
+extern int enc_thread_queue_size;
 extern int vstats_version;
 
 extern const AVIOInterruptCB int_cb;
@@ -652,6 +668,7 @@ int configure_output_filter(FilterGraph *fg, OutputFilter *ofilter, AVFilterInOu
 void check_filter_outputs(void);
 int ist_in_filtergraph(FilterGraph *fg, InputStream *ist);
 int filtergraph_is_simple(FilterGraph *fg);
+int ofilter_forward_frame(OutputFilter *ofilter, AVFrame *frame);
 int init_simple_filtergraph(InputStream *ist, OutputStream *ost);
 int init_complex_filtergraph(FilterGraph *fg);
 
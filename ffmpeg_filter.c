@@ -992,6 +992,78 @@ static void cleanup_filtergraph(FilterGraph *fg)
     avfilter_graph_free(&fg->graph);
 }
 
+/**
+ * Check whether the configured graph passes the frames of its only input to
+ * its only output without modifying them, in which case they can be forwarded
+ * directly to the output.
+ */
+static int filtergraph_is_passthrough(FilterGraph *fg)
+{
+    static const char * const passthrough_filters[] = {
+        "buffer", "abuffer", "buffersink", "abuffersink",
+        "null", "anull", "format", "aformat", NULL
+    };
+    InputFilter  *ifilter;
+    OutputFilter *ofilter;
+    int i, j;
+
+    if (fg->nb_inputs != 1 || fg->nb_outputs != 1)
+        return 0;
+    ifilter = fg->inputs[0];
+    ofilter = fg->outputs[0];
+
+    switch (ifilter->ist->st->codecpar->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        break;
+    case AVMEDIA_TYPE_AUDIO:
+        /* the buffer sink splits the audio into fixed size frames */
+        if (!(ofilter->ost->enc->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE) ||
+            !ifilter->channel_layout)
+            return 0;
+        break;
+    default:
+        return 0;
+    }
+
+    for (i = 0; i < fg->graph->nb_filters; i++) {
+        const char *name = fg->graph->filters[i]->filter->name;
+        for (j = 0; passthrough_filters[j]; j++)
+            if (!strcmp(name, passthrough_filters[j]))
+                break;
+        if (!passthrough_filters[j])
+            return 0;
+    }
+
+    return !av_cmp_q(ifilter->filter->outputs[0]->time_base,
+                     av_buffersink_get_time_base(ofilter->filter));
+}
+
+int ofilter_forward_frame(OutputFilter *ofilter, AVFrame *frame)
+{
+    AVFrame *tmp;
+    int ret;
+
+    if (!ofilter->frame_queue) {
+        ofilter->frame_queue = av_fifo_alloc(8 * sizeof(AVFrame*));
+        if (!ofilter->frame_queue)
+            return AVERROR(ENOMEM);
+    }
+    if (!av_fifo_space(ofilter->frame_queue)) {
+        ret = av_fifo_realloc2(ofilter->frame_queue, 2 * av_fifo_size(ofilter->frame_queue));
+        if (ret < 0)
+            return ret;
+    }
+
+    tmp = av_frame_alloc();
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    av_frame_move_ref(tmp, frame);
+    av_fifo_generic_write(ofilter->frame_queue, &tmp, sizeof(tmp), NULL);
+    ofilter->nb_frames_forwarded++;
+
+    return 0;
+}
+
 int configure_filtergraph(FilterGraph *fg)
 {
     AVFilterInOut *inputs, *outputs, *cur;
@@ -1043,6 +1115,10 @@ int configure_filtergraph(FilterGraph *fg)
         fg->graph->nb_threads = filter_complex_nbthreads;
     }
 
+    if (filter_thread_type &&
+        (ret = av_opt_set(fg->graph, "thread_type", filter_thread_type, 0)) < 0)
+        goto fail;
+
     if ((ret = avfilter_graph_parse2(fg->graph, graph_desc, &inputs, &outputs)) < 0)
         goto fail;
 
@@ -1132,11 +1208,19 @@ int configure_filtergraph(FilterGraph *fg)
                                          ost->enc_ctx->frame_size);
     }
 
+    fg->passthrough = filtergraph_is_passthrough(fg);
+    if (fg->passthrough)
+        av_log(NULL, AV_LOG_VERBOSE, "Filtergraph %d is a pass-through, "
+               "forwarding frames by reference\n", fg->index);
+
     for (i = 0; i < fg->nb_inputs; i++) {
         while (av_fifo_size(fg->inputs[i]->frame_queue)) {
             AVFrame *tmp;
             av_fifo_generic_read(fg->inputs[i]->frame_queue, &tmp, sizeof(tmp), NULL);
-            ret = av_buffersrc_add_frame(fg->inputs[i]->filter, tmp);
+            if (fg->passthrough)
+                ret = ofilter_forward_frame(fg->outputs[0], tmp);
+            else
+                ret = av_buffersrc_add_frame(fg->inputs[i]->filter, tmp);
             av_frame_free(&tmp);
             if (ret < 0)
                 goto fail;
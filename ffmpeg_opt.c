@@ -129,6 +129,8 @@ int frame_bits_per_raw_sample = 0;
 float max_error_rate  = 2.0/3;
 int filter_nbthreads = 0;
 int filter_complex_nbthreads = 0;
+char *filter_thread_type = NULL;
+int enc_thread_queue_size = 0;
 int vstats_version = 2;
 
 
@@ -3489,6 +3491,10 @@ const OptionDef options[] = {
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_threads", HAS_ARG | OPT_INT,                   { &filter_complex_nbthreads },
         "number of threads for -filter_complex" },
+    { "filter_thread_type", HAS_ARG | OPT_STRING | OPT_EXPERT,       { &filter_thread_type },
+        "allowed thread types in filtergraphs (slice, frame)", "flags" },
+    { "enc_thread_queue_size", HAS_ARG | OPT_INT | OPT_EXPERT,        { &enc_thread_queue_size },
+        "run each encoder in its own thread, queueing at most this many frames (0 = disabled)", "frames" },
     { "lavfi",          HAS_ARG | OPT_EXPERT,                        { .func_arg = opt_filter_complex },
         "create a complex filtergraph", "graph_description" },
     { "filter_complex_script", HAS_ARG | OPT_EXPERT,                 { .func_arg = opt_filter_complex_script },
@@ -27,6 +27,7 @@
 #include "put_bits.h"
 
 #include "aac.h"
+#include "aacencdsp.h"
 #include "audio_frame_queue.h"
 #include "psymodel.h"
 
@@ -89,6 +90,16 @@ typedef struct AACQuantizeBandCostCacheEntry {
     uint16_t generation;
 } AACQuantizeBandCostCacheEntry;
 
+/**
+ * State of a channel element carried between the stages of a coding pass
+ */
+typedef struct AACEncElement {
+    FFPsyWindowInfo windows[2];                  ///< window decision of each channel
+    int start_ch;                                ///< index of the first channel
+    int bitres_alloc;                            ///< psy bit allocation per channel
+    int tns_mode, is_mode, pred_mode;            ///< tools used in the current pass
+} AACEncElement;
+
 /**
  * AAC encoder context
  */
@@ -102,12 +113,13 @@ typedef struct AACEncContext {
     float *planar_samples[8];                    ///< saved preprocessed input
 
     int profile;                                 ///< copied from avctx
-    LPCContext lpc;                              ///< used by TNS
     int samplerate_index;                        ///< MPEG-4 samplerate index
     int channels;                                ///< channel count
     const uint8_t *chan_map;                     ///< channel configuration map
 
     ChannelElement *cpe;                         ///< channel elements
+    AACEncElement *elements;                     ///< coding state of the channel elements
+    struct AACEncContext **thread_context;       ///< per channel element copies for slice threading
     FFPsyContext psy;
     struct FFPsyPreprocessContext* psypp;
     AACCoefficientsEncoder *coder;
@@ -120,23 +132,23 @@ typedef struct AACEncContext {
     enum RawDataBlockType cur_type;              ///< channel group type cur_channel belongs to
 
     AudioFrameQueue afq;
-    DECLARE_ALIGNED(16, int,   qcoefs)[96];      ///< quantized coefficients
-    DECLARE_ALIGNED(32, float, scoefs)[1024];    ///< scaled coefficients
-
-    uint16_t quantize_band_cost_cache_generation;
-    AACQuantizeBandCostCacheEntry quantize_band_cost_cache[256][128]; ///< memoization area for quantize_band_cost
 
-    void (*abs_pow34)(float *out, const float *in, const int size);
-    void (*quant_bands)(int *out, const float *in, const float *scaled,
-                        int size, int is_signed, int maxval, const float Q34,
-                        const float rounding);
+    AACEncDSPContext aacdsp;
 
     struct {
         float *samples;
     } buffer;
+
+    /* Scratch space, each thread_context[] has its own copy of the fields
+     * below, the ones above are copied from the main context. */
+    LPCContext lpc;                              ///< used by TNS
+    DECLARE_ALIGNED(16, int,   qcoefs)[96];      ///< quantized coefficients
+    DECLARE_ALIGNED(32, float, scoefs)[1024];    ///< scaled coefficients
+
+    uint16_t quantize_band_cost_cache_generation;
+    AACQuantizeBandCostCacheEntry quantize_band_cost_cache[256][128]; ///< memoization area for quantize_band_cost
 } AACEncContext;
 
-void ff_aac_dsp_init_x86(AACEncContext *s);
 void ff_aac_coder_init_mips(AACEncContext *c);
 void ff_quantize_band_cost_cache_init(struct AACEncContext *s);
 
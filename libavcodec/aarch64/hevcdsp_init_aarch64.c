@@ -0,0 +1,173 @@
+/*
+ * AArch64 NEON optimised DSP functions for HEVC decoding
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libavutil/attributes.h"
+#include "libavutil/aarch64/cpu.h"
+#include "libavcodec/hevcdsp.h"
+
+#define decl_add_residual(sz, depth)                                       \
+void ff_hevc_add_residual_##sz##x##sz##_neon_##depth(uint8_t *dst,         \
+                                                     int16_t *res,         \
+                                                     ptrdiff_t stride)
+
+#define decl_idct(sz, depth)                                               \
+void ff_hevc_idct_##sz##x##sz##_neon_##depth(int16_t *coeffs,              \
+                                             int col_limit);               \
+void ff_hevc_idct_##sz##x##sz##_dc_neon_##depth(int16_t *coeffs)
+
+#define decl_dsp_funcs(depth)                                              \
+decl_add_residual(4,  depth);                                              \
+decl_add_residual(8,  depth);                                              \
+decl_add_residual(16, depth);                                              \
+decl_add_residual(32, depth);                                              \
+decl_idct(4,  depth);                                                      \
+decl_idct(8,  depth);                                                      \
+decl_idct(16, depth);                                                      \
+decl_idct(32, depth);                                                      \
+                                                                           \
+void ff_hevc_sao_band_filter_neon_##depth(uint8_t *dst, uint8_t *src,      \
+                                          ptrdiff_t stride_dst,            \
+                                          ptrdiff_t stride_src,            \
+                                          int16_t *sao_offset_val,         \
+                                          int sao_left_class,              \
+                                          int width, int height);          \
+void ff_hevc_sao_edge_filter_neon_##depth(uint8_t *dst, uint8_t *src,      \
+                                          ptrdiff_t stride_dst,            \
+                                          int16_t *sao_offset_val,         \
+                                          int eo, int width, int height);  \
+                                                                           \
+void ff_hevc_h_loop_filter_luma_neon_##depth(uint8_t *pix, ptrdiff_t stride, \
+                                             int beta, int32_t *tc,        \
+                                             uint8_t *no_p, uint8_t *no_q); \
+void ff_hevc_v_loop_filter_luma_neon_##depth(uint8_t *pix, ptrdiff_t stride, \
+                                             int beta, int32_t *tc,        \
+                                             uint8_t *no_p, uint8_t *no_q); \
+void ff_hevc_h_loop_filter_chroma_neon_##depth(uint8_t *pix, ptrdiff_t stride, \
+                                               int32_t *tc, uint8_t *no_p, \
+                                               uint8_t *no_q);             \
+void ff_hevc_v_loop_filter_chroma_neon_##depth(uint8_t *pix, ptrdiff_t stride, \
+                                               int32_t *tc, uint8_t *no_p, \
+                                               uint8_t *no_q)
+
+decl_dsp_funcs(8);
+decl_dsp_funcs(10);
+
+#define decl_mc_funcs(type, dir)                                           \
+void ff_hevc_put_##type##_##dir##_neon_8(int16_t *dst, uint8_t *src,       \
+                                         ptrdiff_t srcstride, int height,  \
+                                         intptr_t mx, intptr_t my,         \
+                                         int width);                       \
+void ff_hevc_put_##type##_uni_##dir##_neon_8(uint8_t *dst,                 \
+                                             ptrdiff_t dststride,          \
+                                             uint8_t *src,                 \
+                                             ptrdiff_t srcstride,          \
+                                             int height, intptr_t mx,      \
+                                             intptr_t my, int width);      \
+void ff_hevc_put_##type##_uni_w_##dir##_neon_8(uint8_t *dst,               \
+                                               ptrdiff_t dststride,        \
+                                               uint8_t *src,               \
+                                               ptrdiff_t srcstride,        \
+                                               int height, int denom,      \
+                                               int wx, int ox,             \
+                                               intptr_t mx, intptr_t my,   \
+                                               int width);                 \
+void ff_hevc_put_##type##_bi_##dir##_neon_8(uint8_t *dst,                  \
+                                            ptrdiff_t dststride,           \
+                                            uint8_t *src,                  \
+                                            ptrdiff_t srcstride,           \
+                                            int16_t *src2, int height,     \
+                                            intptr_t mx, intptr_t my,      \
+                                            int width);                    \
+void ff_hevc_put_##type##_bi_w_##dir##_neon_8(uint8_t *dst,                \
+                                              ptrdiff_t dststride,         \
+                                              uint8_t *src,                \
+                                              ptrdiff_t srcstride,         \
+                                              int16_t *src2, int height,   \
+                                              int denom, int wx0, int wx1, \
+                                              int ox0, int ox1,            \
+                                              intptr_t mx, intptr_t my,    \
+                                              int width)
+
+decl_mc_funcs(pel,  pixels);
+decl_mc_funcs(qpel, h);
+decl_mc_funcs(qpel, v);
+decl_mc_funcs(qpel, hv);
+decl_mc_funcs(epel, h);
+decl_mc_funcs(epel, v);
+decl_mc_funcs(epel, hv);
+
+// The MC functions handle any block width, so they are used for all of them.
+#define set_mc_funcs(table, v, h, type, dir)                               \
+    for (i = 0; i < 10; i++) {                                             \
+        c->put_hevc_##table[i][v][h]         = ff_hevc_put_##type##_##dir##_neon_8;       \
+        c->put_hevc_##table##_uni[i][v][h]   = ff_hevc_put_##type##_uni_##dir##_neon_8;   \
+        c->put_hevc_##table##_uni_w[i][v][h] = ff_hevc_put_##type##_uni_w_##dir##_neon_8; \
+        c->put_hevc_##table##_bi[i][v][h]    = ff_hevc_put_##type##_bi_##dir##_neon_8;    \
+        c->put_hevc_##table##_bi_w[i][v][h]  = ff_hevc_put_##type##_bi_w_##dir##_neon_8;  \
+    }
+
+#define set_dsp_funcs(depth)                                               \
+    c->add_residual[0] = ff_hevc_add_residual_4x4_neon_##depth;            \
+    c->add_residual[1] = ff_hevc_add_residual_8x8_neon_##depth;            \
+    c->add_residual[2] = ff_hevc_add_residual_16x16_neon_##depth;          \
+    c->add_residual[3] = ff_hevc_add_residual_32x32_neon_##depth;          \
+    c->idct[0]         = ff_hevc_idct_4x4_neon_##depth;                    \
+    c->idct[1]         = ff_hevc_idct_8x8_neon_##depth;                    \
+    c->idct[2]         = ff_hevc_idct_16x16_neon_##depth;                  \
+    c->idct[3]         = ff_hevc_idct_32x32_neon_##depth;                  \
+    c->idct_dc[0]      = ff_hevc_idct_4x4_dc_neon_##depth;                 \
+    c->idct_dc[1]      = ff_hevc_idct_8x8_dc_neon_##depth;                 \
+    c->idct_dc[2]      = ff_hevc_idct_16x16_dc_neon_##depth;               \
+    c->idct_dc[3]      = ff_hevc_idct_32x32_dc_neon_##depth;               \
+    for (i = 0; i < 5; i++) {                                              \
+        c->sao_band_filter[i] = ff_hevc_sao_band_filter_neon_##depth;      \
+        c->sao_edge_filter[i] = ff_hevc_sao_edge_filter_neon_##depth;      \
+    }                                                                      \
+    c->hevc_h_loop_filter_luma   = ff_hevc_h_loop_filter_luma_neon_##depth;   \
+    c->hevc_v_loop_filter_luma   = ff_hevc_v_loop_filter_luma_neon_##depth;   \
+    c->hevc_h_loop_filter_chroma = ff_hevc_h_loop_filter_chroma_neon_##depth; \
+    c->hevc_v_loop_filter_chroma = ff_hevc_v_loop_filter_chroma_neon_##depth
+
+av_cold void ff_hevc_dsp_init_aarch64(HEVCDSPContext *c, const int bit_depth)
+{
+    int cpu_flags = av_get_cpu_flags();
+    int i;
+
+    if (!have_neon(cpu_flags))
+        return;
+
+    if (bit_depth == 8) {
+        set_dsp_funcs(8);
+
+        set_mc_funcs(qpel, 0, 0, pel,  pixels);
+        set_mc_funcs(qpel, 0, 1, qpel, h);
+        set_mc_funcs(qpel, 1, 0, qpel, v);
+        set_mc_funcs(qpel, 1, 1, qpel, hv);
+        set_mc_funcs(epel, 0, 0, pel,  pixels);
+        set_mc_funcs(epel, 0, 1, epel, h);
+        set_mc_funcs(epel, 1, 0, epel, v);
+        set_mc_funcs(epel, 1, 1, epel, hv);
+    } else if (bit_depth == 10) {
+        set_dsp_funcs(10);
+    }
+}
@@ -100,6 +100,15 @@ typedef struct FlacFrame {
     int verbatim_only;
 } FlacFrame;
 
+typedef struct FlacEncodeSlot {
+    AVFrame *frame;                 ///< queued input frame
+    uint32_t frame_count;           ///< coded frame number
+    int max_framesize;              ///< verbatim fallback threshold
+    uint8_t *buf;                   ///< coded frame
+    unsigned int buf_size;
+    int size;                       ///< size of the coded frame or error code
+} FlacEncodeSlot;
+
 typedef struct FlacEncodeContext {
     AVClass *class;
     PutBitContext pb;
@@ -126,6 +135,15 @@ typedef struct FlacEncodeContext {
 
     int flushed;
     int64_t next_pts;
+
+    /* frame threading: input frames are queued in slots[] and coded in
+     * batches of avctx->thread_count frames, one thread_context per thread */
+    struct FlacEncodeContext **thread_context;
+    FlacEncodeSlot *slots;
+    int nb_slots;
+    int slot_out;                   ///< next coded frame to output
+    int slot_enc;                   ///< first queued frame not yet coded
+    int slot_in;                    ///< next free slot
 } FlacEncodeContext;
 
 
@@ -463,7 +481,31 @@ FF_ENABLE_DEPRECATION_WARNINGS
 
     dprint_compression_options(s);
 
-    return ret;
+    if (ret < 0)
+        return ret;
+
+    if (avctx->active_thread_type & FF_THREAD_SLICE && avctx->thread_count > 1) {
+        s->nb_slots = avctx->thread_count + 1;
+        s->slots    = av_mallocz_array(s->nb_slots, sizeof(*s->slots));
+        s->thread_context = av_mallocz_array(avctx->thread_count,
+                                             sizeof(*s->thread_context));
+        if (!s->slots || !s->thread_context)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < avctx->thread_count; i++) {
+            FlacEncodeContext *t = av_malloc(sizeof(*t));
+            if (!t)
+                return AVERROR(ENOMEM);
+            memcpy(t, s, sizeof(*t));
+            memset(&t->lpc_ctx, 0, sizeof(t->lpc_ctx));
+            s->thread_context[i] = t;
+            ret = ff_lpc_init(&t->lpc_ctx, avctx->frame_size,
+                              s->options.max_prediction_order, FF_LPC_TYPE_LEVINSON);
+            if (ret < 0)
+                return ret;
+        }
+    }
+
+    return 0;
 }
 
 
@@ -1310,9 +1352,9 @@ static void write_frame_footer(FlacEncodeContext *s)
 }
 
 
-static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
+static int write_frame(FlacEncodeContext *s, uint8_t *buf, int buf_size)
 {
-    init_put_bits(&s->pb, avpkt->data, avpkt->size);
+    init_put_bits(&s->pb, buf, buf_size);
     write_frame_header(s);
     write_subframes(s);
     write_frame_footer(s);
@@ -1320,10 +1362,11 @@ static int write_frame(FlacEncodeContext *s, AVPacket *avpkt)
 }
 
 
-static int update_md5_sum(FlacEncodeContext *s, const void *samples)
+static int update_md5_sum(FlacEncodeContext *s, const void *samples,
+                          int nb_samples)
 {
     const uint8_t *buf;
-    int buf_size = s->frame.blocksize * s->channels *
+    int buf_size = nb_samples * s->channels *
                    ((s->avctx->bits_per_raw_sample + 7) / 8);
 
     if (s->avctx->bits_per_raw_sample > 16 || HAVE_BIGENDIAN) {
@@ -1344,7 +1387,7 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
         const int32_t *samples0 = samples;
         uint8_t *tmp            = s->md5_buffer;
 
-        for (i = 0; i < s->frame.blocksize * s->channels; i++) {
+        for (i = 0; i < nb_samples * s->channels; i++) {
             int32_t v = samples0[i] >> 8;
             AV_WL24(tmp + 3*i, v);
         }
@@ -1356,6 +1399,154 @@ static int update_md5_sum(FlacEncodeContext *s, const void *samples)
 }
 
 
+/**
+ * Code one frame of samples into s->frame.
+ * @return size of the coded frame in bytes or a negative error code
+ */
+static int encode_samples(FlacEncodeContext *s, const AVFrame *frame)
+{
+    int frame_bytes;
+
+    init_frame(s, frame->nb_samples);
+
+    copy_samples(s, frame->data[0]);
+
+    channel_decorrelation(s);
+
+    remove_wasted_bits(s);
+
+    frame_bytes = encode_frame(s);
+
+    /* Fall back on verbatim mode if the compressed frame is larger than it
+       would be if encoded uncompressed. */
+    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
+        s->frame.verbatim_only = 1;
+        frame_bytes = encode_frame(s);
+        if (frame_bytes < 0) {
+            av_log(s->avctx, AV_LOG_ERROR, "Bad frame count\n");
+            return frame_bytes;
+        }
+    }
+
+    return frame_bytes;
+}
+
+
+/**
+ * Account for a coded frame in the stream info and the MD5 sum,
+ * and set the packet properties.
+ */
+static int finish_packet(FlacEncodeContext *s, AVPacket *avpkt,
+                         const AVFrame *frame, int out_bytes)
+{
+    int ret;
+
+    s->sample_count += frame->nb_samples;
+    if ((ret = update_md5_sum(s, frame->data[0], frame->nb_samples)) < 0) {
+        av_log(s->avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+        return ret;
+    }
+    if (out_bytes > s->max_encoded_framesize)
+        s->max_encoded_framesize = out_bytes;
+    if (out_bytes < s->min_framesize)
+        s->min_framesize = out_bytes;
+
+    avpkt->pts      = frame->pts;
+    avpkt->duration = ff_samples_to_time_base(s->avctx, frame->nb_samples);
+    avpkt->size     = out_bytes;
+
+    s->next_pts = avpkt->pts + avpkt->duration;
+
+    return 0;
+}
+
+
+static int encode_slot(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeContext *t = s->thread_context[threadnr];
+    FlacEncodeSlot *slot = &s->slots[(s->slot_enc + jobnr) % s->nb_slots];
+    int frame_bytes;
+
+    t->frame_count   = slot->frame_count;
+    t->max_framesize = slot->max_framesize;
+
+    frame_bytes = encode_samples(t, slot->frame);
+    if (frame_bytes < 0) {
+        slot->size = frame_bytes;
+        return 0;
+    }
+
+    av_fast_malloc(&slot->buf, &slot->buf_size, frame_bytes);
+    if (!slot->buf) {
+        slot->size = AVERROR(ENOMEM);
+        return 0;
+    }
+
+    slot->size = write_frame(t, slot->buf, frame_bytes);
+    return 0;
+}
+
+
+/**
+ * Queue a frame and return the oldest coded frame, if any. Frames are
+ * coded in parallel once a full batch is queued and no coded frames are
+ * left, or when flushing. The frame number, the verbatim fallback size and
+ * the MD5 sum follow the input order, so the output matches serial coding.
+ */
+static int encode_frame_threaded(AVCodecContext *avctx, AVPacket *avpkt,
+                                 const AVFrame *frame, int *got_packet_ptr)
+{
+    FlacEncodeContext *s = avctx->priv_data;
+    FlacEncodeSlot *slot;
+    int ret;
+
+    if (frame) {
+        slot = &s->slots[s->slot_in % s->nb_slots];
+        if (!slot->frame && !(slot->frame = av_frame_alloc()))
+            return AVERROR(ENOMEM);
+        if ((ret = av_frame_ref(slot->frame, frame)) < 0)
+            return ret;
+
+        /* change max_framesize for small final frame; s->frame is not used
+           for coding here, it only keeps track of the previous block size */
+        if (frame->nb_samples < s->frame.blocksize) {
+            s->max_framesize = ff_flac_get_max_frame_size(frame->nb_samples,
+                                                          s->channels,
+                                                          avctx->bits_per_raw_sample);
+        }
+        s->frame.blocksize = frame->nb_samples;
+
+        slot->frame_count   = s->frame_count++;
+        slot->max_framesize = s->max_framesize;
+        s->slot_in++;
+    }
+
+    if (s->slot_out == s->slot_enc &&
+        (s->slot_in - s->slot_enc == avctx->thread_count ||
+         !frame && s->slot_in > s->slot_enc)) {
+        avctx->execute2(avctx, encode_slot, NULL, NULL, s->slot_in - s->slot_enc);
+        s->slot_enc = s->slot_in;
+    }
+
+    if (s->slot_out == s->slot_enc)
+        return 0;
+
+    slot = &s->slots[s->slot_out++ % s->nb_slots];
+    if ((ret = slot->size) >= 0 &&
+        (ret = ff_alloc_packet2(avctx, avpkt, slot->size, 0)) >= 0) {
+        memcpy(avpkt->data, slot->buf, slot->size);
+        ret = finish_packet(s, avpkt, slot->frame, slot->size);
+    }
+    av_frame_unref(slot->frame);
+    if (ret < 0)
+        return ret;
+
+    *got_packet_ptr = 1;
+    return 0;
+}
+
+
 static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
                              const AVFrame *frame, int *got_packet_ptr)
 {
@@ -1364,6 +1555,12 @@ static int flac_encode_frame(AVCodecContext *avctx, AVPacket *avpkt,
 
     s = avctx->priv_data;
 
+    if (s->nb_slots) {
+        ret = encode_frame_threaded(avctx, avpkt, frame, got_packet_ptr);
+        if (ret < 0 || *got_packet_ptr || frame)
+            return ret;
+    }
+
     /* when the last block is reached, update the header in extradata */
     if (!frame) {
         s->max_framesize = s->max_encoded_framesize;
@@ -1399,48 +1596,18 @@ FF_ENABLE_DEPRECATION_WARNINGS
                                                       avctx->bits_per_raw_sample);
     }
 
-    init_frame(s, frame->nb_samples);
-
-    copy_samples(s, frame->data[0]);
-
-    channel_decorrelation(s);
-
-    remove_wasted_bits(s);
-
-    frame_bytes = encode_frame(s);
-
-    /* Fall back on verbatim mode if the compressed frame is larger than it
-       would be if encoded uncompressed. */
-    if (frame_bytes < 0 || frame_bytes > s->max_framesize) {
-        s->frame.verbatim_only = 1;
-        frame_bytes = encode_frame(s);
-        if (frame_bytes < 0) {
-            av_log(avctx, AV_LOG_ERROR, "Bad frame count\n");
-            return frame_bytes;
-        }
-    }
+    frame_bytes = encode_samples(s, frame);
+    if (frame_bytes < 0)
+        return frame_bytes;
 
     if ((ret = ff_alloc_packet2(avctx, avpkt, frame_bytes, 0)) < 0)
         return ret;
 
-    out_bytes = write_frame(s, avpkt);
+    out_bytes = write_frame(s, avpkt->data, avpkt->size);
 
     s->frame_count++;
-    s->sample_count += frame->nb_samples;
-    if ((ret = update_md5_sum(s, frame->data[0])) < 0) {
-        av_log(avctx, AV_LOG_ERROR, "Error updating MD5 checksum\n");
+    if ((ret = finish_packet(s, avpkt, frame, out_bytes)) < 0)
         return ret;
-    }
-    if (out_bytes > s->max_encoded_framesize)
-        s->max_encoded_framesize = out_bytes;
-    if (out_bytes < s->min_framesize)
-        s->min_framesize = out_bytes;
-
-    avpkt->pts      = frame->pts;
-    avpkt->duration = ff_samples_to_time_base(avctx, frame->nb_samples);
-    avpkt->size     = out_bytes;
-
-    s->next_pts = avpkt->pts + avpkt->duration;
 
     *got_packet_ptr = 1;
     return 0;
@@ -1451,9 +1618,25 @@ static av_cold int flac_encode_close(AVCodecContext *avctx)
 {
     if (avctx->priv_data) {
         FlacEncodeContext *s = avctx->priv_data;
+        int i;
         av_freep(&s->md5ctx);
         av_freep(&s->md5_buffer);
         ff_lpc_end(&s->lpc_ctx);
+        if (s->thread_context) {
+            for (i = 0; i < avctx->thread_count; i++) {
+                if (s->thread_context[i])
+                    ff_lpc_end(&s->thread_context[i]->lpc_ctx);
+                av_freep(&s->thread_context[i]);
+            }
+            av_freep(&s->thread_context);
+        }
+        if (s->slots) {
+            for (i = 0; i < s->nb_slots; i++) {
+                av_frame_free(&s->slots[i].frame);
+                av_freep(&s->slots[i].buf);
+            }
+            av_freep(&s->slots);
+        }
     }
     av_freep(&avctx->extradata);
     avctx->extradata_size = 0;
@@ -1508,7 +1691,9 @@ AVCodec ff_flac_encoder = {
     .init           = flac_encode_init,
     .encode2        = flac_encode_frame,
     .close          = flac_encode_close,
-    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_LOSSLESS,
+    .capabilities   = AV_CODEC_CAP_SMALL_LAST_FRAME | AV_CODEC_CAP_DELAY | AV_CODEC_CAP_LOSSLESS |
+                      AV_CODEC_CAP_SLICE_THREADS,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
     .sample_fmts    = (const enum AVSampleFormat[]){ AV_SAMPLE_FMT_S16,
                                                      AV_SAMPLE_FMT_S32,
                                                      AV_SAMPLE_FMT_NONE },
@@ -3313,6 +3313,28 @@ static int hevc_update_thread_context(AVCodecContext *dst,
     return 0;
 }
 
+/**
+ * Give each frame thread its own pool of WPP threads, so that frame
+ * threading and wavefront decoding can be combined.
+ */
+static av_cold int hevc_init_slice_threads(AVCodecContext *avctx)
+{
+    HEVCContext *s = avctx->priv_data;
+    int ret;
+
+    s->threads_number = 1;
+    if (!(avctx->thread_type & FF_THREAD_SLICE) || s->slice_threads <= 1)
+        return 0;
+
+    ret = ff_slice_thread_init_nested(avctx, s->slice_threads);
+    if (ret < 0)
+        return ret;
+    if (avctx->internal->slice_thread_ctx)
+        s->threads_number = s->slice_threads;
+
+    return 0;
+}
+
 static av_cold int hevc_decode_init(AVCodecContext *avctx)
 {
     HEVCContext *s = avctx->priv_data;
@@ -3332,7 +3354,13 @@ static av_cold int hevc_decode_init(AVCodecContext *avctx)
 
     if(avctx->active_thread_type & FF_THREAD_SLICE)
         s->threads_number = avctx->thread_count;
-    else
+    else if (avctx->active_thread_type & FF_THREAD_FRAME) {
+        ret = hevc_init_slice_threads(avctx);
+        if (ret < 0) {
+            hevc_decode_free(avctx);
+            return ret;
+        }
+    } else
         s->threads_number = 1;
 
     if (avctx->extradata_size > 0 && avctx->extradata) {
@@ -3354,15 +3382,17 @@ static av_cold int hevc_decode_init(AVCodecContext *avctx)
 static av_cold int hevc_init_thread_copy(AVCodecContext *avctx)
 {
     HEVCContext *s = avctx->priv_data;
+    int slice_threads = s->slice_threads;
     int ret;
 
     memset(s, 0, sizeof(*s));
+    s->slice_threads = slice_threads;
 
     ret = hevc_init_context(avctx);
     if (ret < 0)
         return ret;
 
-    return 0;
+    return hevc_init_slice_threads(avctx);
 }
 
 static void hevc_decode_flush(AVCodecContext *avctx)
@@ -3381,6 +3411,8 @@ static const AVOption options[] = {
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
     { "strict-displaywin", "stricly apply default display window size", OFFSET(apply_defdispwin),
         AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, PAR },
+    { "slice_threads", "Number of WPP threads used by each frame thread", OFFSET(slice_threads),
+        AV_OPT_TYPE_INT, {.i64 = 1}, 1, MAX_NB_THREADS, PAR },
     { NULL },
 };
 
@@ -152,6 +152,7 @@ typedef struct AVCodecInternal {
     FramePool *pool;
 
     void *thread_ctx;
+    void *slice_thread_ctx;
 
     DecodeSimpleContext ds;
     DecodeFilterContext filter;
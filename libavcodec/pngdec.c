@@ -91,6 +91,14 @@ typedef struct PNGDecContext {
     int pass_row_size; /* decompress row size of the current pass */
     int y;
     z_stream zstream;
+
+    /* slice threading: all rows are inflated first, then unfiltered */
+    int unfilter_slices;
+    uint8_t *rows_buf;
+    unsigned int rows_buf_size;
+    int rows_stride;
+    int *band_start;
+    int nb_bands;
 } PNGDecContext;
 
 /* Mask to determine which pixels are valid in a pass */
@@ -318,13 +326,67 @@ static void deloco_ ## NAME(TYPE *dst, int size, int alpha) \
 YUV2RGB(rgb8, uint8_t)
 YUV2RGB(rgb16, uint16_t)
 
+static int unfilter_band(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGDecContext *s = avctx->priv_data;
+    int bpp          = *(int *)arg;
+    uint8_t *ptr, *crow, *last_row;
+    int y;
+
+    for (y = s->band_start[jobnr]; y < s->band_start[jobnr + 1]; y++) {
+        ptr  = s->image_buf + s->image_linesize * (y + s->y_offset) + s->x_offset * bpp;
+        crow = s->rows_buf + y * s->rows_stride + 15;
+        last_row = y ? ptr - s->image_linesize : s->last_row;
+
+        png_filter_row(&s->dsp, ptr, crow[0], crow + 1, last_row, s->row_size, bpp);
+    }
+    return 0;
+}
+
+/**
+ * Unfilter the first s->y rows of a non-interlaced image. Rows filtered
+ * with NONE or SUB do not depend on the row above, so the image is split
+ * at such rows into bands that are unfiltered in parallel.
+ *
+ * @param bpp bytes per pixel of the decompressed rows, i.e. without the
+ *            alpha channel added for tRNS
+ */
+static void png_unfilter_rows(PNGDecContext *s, int bpp)
+{
+    int nb_threads = s->avctx->thread_count;
+    int i, y = 0;
+
+    s->band_start[0] = 0;
+    s->nb_bands      = 0;
+    for (i = 1; i < nb_threads; i++) {
+        y = FFMAX(y + 1, s->y * i / nb_threads);
+        while (y < s->y &&
+               s->rows_buf[y * s->rows_stride + 15] != PNG_FILTER_VALUE_NONE &&
+               s->rows_buf[y * s->rows_stride + 15] != PNG_FILTER_VALUE_SUB)
+            y++;
+        if (y >= s->y)
+            break;
+        s->band_start[++s->nb_bands] = y;
+    }
+    s->band_start[++s->nb_bands] = s->y;
+
+    s->avctx->execute2(s->avctx, unfilter_band, &bpp, NULL, s->nb_bands);
+
+    if (s->y == s->cur_h)
+        s->pic_state |= PNG_ALLIMAGE;
+}
+
 /* process exactly one decompressed row */
 static void png_handle_row(PNGDecContext *s)
 {
     uint8_t *ptr, *last_row;
     int got_line;
 
-    if (!s->interlace_type) {
+    if (s->unfilter_slices) {
+        s->y++;
+        if (s->y == s->cur_h)
+            png_unfilter_rows(s, s->bpp);
+    } else if (!s->interlace_type) {
         ptr = s->image_buf + s->image_linesize * (s->y + s->y_offset) + s->x_offset * s->bpp;
         if (s->y == 0)
             last_row = s->last_row;
@@ -420,6 +482,8 @@ static int png_decode_idat(PNGDecContext *s, int length)
             }
             s->zstream.avail_out = s->crow_size;
             s->zstream.next_out  = s->crow_buf;
+            if (!(s->pic_state & PNG_ALLIMAGE) && s->unfilter_slices)
+                s->zstream.next_out = s->rows_buf + s->y * s->rows_stride + 15;
         }
         if (ret == Z_STREAM_END && s->zstream.avail_in > 0) {
             av_log(NULL, AV_LOG_WARNING,
@@ -744,6 +808,18 @@ static int decode_idat_chunk(AVCodecContext *avctx, PNGDecContext *s,
         s->crow_buf          = s->buffer + 15;
         s->zstream.avail_out = s->crow_size;
         s->zstream.next_out  = s->crow_buf;
+
+        s->unfilter_slices = s->band_start && !s->interlace_type &&
+                             s->filter_type != PNG_FILTER_TYPE_LOCO;
+        if (s->unfilter_slices) {
+            /* same alignment as crow_buf for each row */
+            s->rows_stride = FFALIGN(s->row_size + 16, 16);
+            av_fast_padded_malloc(&s->rows_buf, &s->rows_buf_size,
+                                  (size_t)s->cur_h * s->rows_stride);
+            if (!s->rows_buf)
+                return AVERROR(ENOMEM);
+            s->zstream.next_out = s->rows_buf + 15;
+        }
     }
 
     s->pic_state |= PNG_IDAT;
@@ -1262,6 +1338,14 @@ exit_loop:
         return 0;
     }
 
+    /* unfilter the rows of a truncated image */
+    if (s->unfilter_slices && !(s->pic_state & PNG_ALLIMAGE) && s->y) {
+        int bpp = s->bpp;
+        if (s->has_trns && s->color_type != PNG_COLOR_TYPE_PALETTE)
+            bpp -= s->bit_depth > 8 ? 2 : 1;
+        png_unfilter_rows(s, bpp);
+    }
+
     if (s->bits_per_pixel <= 4)
         handle_small_bpp(s, p);
 
@@ -1491,6 +1575,13 @@ static av_cold int png_dec_init(AVCodecContext *avctx)
     avctx->color_range = AVCOL_RANGE_JPEG;
 
     s->avctx = avctx;
+
+    if (avctx->active_thread_type & FF_THREAD_SLICE) {
+        s->band_start = av_malloc_array(avctx->thread_count + 1, sizeof(*s->band_start));
+        if (!s->band_start)
+            return AVERROR(ENOMEM);
+    }
+
     s->previous_picture.f = av_frame_alloc();
     s->last_picture.f = av_frame_alloc();
     s->picture.f = av_frame_alloc();
@@ -1498,6 +1589,7 @@ static av_cold int png_dec_init(AVCodecContext *avctx)
         av_frame_free(&s->previous_picture.f);
         av_frame_free(&s->last_picture.f);
         av_frame_free(&s->picture.f);
+        av_freep(&s->band_start);
         return AVERROR(ENOMEM);
     }
 
@@ -1525,6 +1617,9 @@ static av_cold int png_dec_end(AVCodecContext *avctx)
     s->last_row_size = 0;
     av_freep(&s->tmp_row);
     s->tmp_row_size = 0;
+    av_freep(&s->rows_buf);
+    s->rows_buf_size = 0;
+    av_freep(&s->band_start);
 
     return 0;
 }
@@ -1558,7 +1653,8 @@ AVCodec ff_png_decoder = {
     .decode         = decode_frame_png,
     .init_thread_copy = ONLY_IF_THREADS_ENABLED(png_dec_init),
     .update_thread_context = ONLY_IF_THREADS_ENABLED(update_thread_context),
-    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS /*| AV_CODEC_CAP_DRAW_HORIZ_BAND*/,
+    .capabilities   = AV_CODEC_CAP_DR1 | AV_CODEC_CAP_FRAME_THREADS |
+                      AV_CODEC_CAP_SLICE_THREADS /*| AV_CODEC_CAP_DRAW_HORIZ_BAND*/,
     .caps_internal  = FF_CODEC_CAP_SKIP_FRAME_FILL_PARAM | FF_CODEC_CAP_INIT_THREADSAFE,
 };
 #endif
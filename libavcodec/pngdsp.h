@@ -35,6 +35,7 @@ typedef struct PNGDSPContext {
 } PNGDSPContext;
 
 void ff_pngdsp_init(PNGDSPContext *dsp);
+void ff_pngdsp_init_aarch64(PNGDSPContext *dsp);
 void ff_pngdsp_init_x86(PNGDSPContext *dsp);
 
 #endif /* AVCODEC_PNGDSP_H */
@@ -36,6 +36,7 @@
 #include <zlib.h>
 
 #define IOBUF_SIZE 4096
+#define MIN_BAND_HEIGHT 16
 
 typedef struct APNGFctlChunk {
     uint32_t sequence_number;
@@ -45,6 +46,15 @@ typedef struct APNGFctlChunk {
     uint8_t dispose_op, blend_op;
 } APNGFctlChunk;
 
+typedef struct PNGEncSlice {
+    z_stream zstream;            ///< raw deflate stream of the band
+    uint8_t *crow_base;
+    uint8_t *buf;
+    unsigned int buf_size;
+    int size;                    ///< coded size of the band or error code
+    uLong adler;                 ///< Adler-32 of the filtered rows of the band
+} PNGEncSlice;
+
 typedef struct PNGEncContext {
     AVClass *class;
     LLVidEncDSPContext llvidencdsp;
@@ -64,6 +74,11 @@ typedef struct PNGEncContext {
     int bit_depth;
     int color_type;
     int bits_per_pixel;
+    int zlib_header;
+
+    PNGEncSlice *slices;
+    int nb_slices;
+    int nb_bands;
 
     // APNG
     uint32_t palette_checksum;   // Used to ensure a single unique palette
@@ -428,6 +443,113 @@ static int encode_headers(AVCodecContext *avctx, const AVFrame *pict)
     return 0;
 }
 
+static int encode_slice(AVCodecContext *avctx, void *arg, int jobnr, int threadnr)
+{
+    PNGEncContext *s      = avctx->priv_data;
+    const AVFrame *pict   = arg;
+    PNGEncSlice *sl       = &s->slices[jobnr];
+    int nb_bands          = s->nb_bands;
+    int row_size          = (pict->width * s->bits_per_pixel + 7) >> 3;
+    int y_start           = pict->height *  jobnr      / nb_bands;
+    int y_end             = pict->height * (jobnr + 1) / nb_bands;
+    uint8_t *crow_buf     = sl->crow_base + 15;
+    uint8_t *ptr, *crow, *top = NULL;
+    int y, ret;
+
+    sl->zstream.next_out  = sl->buf;
+    sl->zstream.avail_out = sl->buf_size;
+    sl->adler             = adler32(0, NULL, 0);
+
+    /* the first row of each band is filtered without the row above, so
+     * the bands can be unfiltered independently as well */
+    for (y = y_start; y < y_end; y++) {
+        ptr  = pict->data[0] + y * pict->linesize[0];
+        crow = png_choose_filter(s, crow_buf, ptr, top,
+                                 row_size, s->bits_per_pixel >> 3);
+        sl->adler = adler32(sl->adler, crow, row_size + 1);
+        sl->zstream.next_in  = crow;
+        sl->zstream.avail_in = row_size + 1;
+        while (sl->zstream.avail_in > 0) {
+            if (deflate(&sl->zstream, Z_NO_FLUSH) != Z_OK) {
+                sl->size = AVERROR_EXTERNAL;
+                goto end;
+            }
+        }
+        top = ptr;
+    }
+
+    /* all bands but the last end on a byte boundary without the final
+     * block bit, so that they can simply be concatenated */
+    ret = deflate(&sl->zstream, jobnr == nb_bands - 1 ? Z_FINISH : Z_SYNC_FLUSH);
+    if (ret != (jobnr == nb_bands - 1 ? Z_STREAM_END : Z_OK) ||
+        !sl->zstream.avail_out) {
+        sl->size = AVERROR_EXTERNAL;
+        goto end;
+    }
+    sl->size = sl->buf_size - sl->zstream.avail_out;
+
+end:
+    deflateReset(&sl->zstream);
+    return 0;
+}
+
+/**
+ * Filter and compress bands of rows in parallel. Each band is an
+ * independent raw deflate stream; the zlib header and the Adler-32 of the
+ * whole image data are added here and each band is written as one chunk.
+ */
+static int encode_frame_slices(AVCodecContext *avctx, const AVFrame *pict,
+                               int nb_bands)
+{
+    PNGEncContext *s = avctx->priv_data;
+    int row_size     = (pict->width * s->bits_per_pixel + 7) >> 3;
+    uLong adler      = adler32(0, NULL, 0);
+    int i, rows, size;
+
+    for (i = 0; i < nb_bands; i++) {
+        PNGEncSlice *sl = &s->slices[i];
+
+        rows = pict->height * (i + 1) / nb_bands - pict->height * i / nb_bands;
+        /* 16 bytes for the empty stored block of the sync flush, 6 for the
+         * zlib header and trailer */
+        av_fast_malloc(&sl->buf, &sl->buf_size,
+                       deflateBound(&sl->zstream, (uLong)rows * (row_size + 1)) + 22);
+        if (!sl->buf)
+            return AVERROR(ENOMEM);
+    }
+
+    s->nb_bands = nb_bands;
+    avctx->execute2(avctx, encode_slice, (void *)pict, NULL, nb_bands);
+
+    for (i = 0; i < nb_bands; i++) {
+        PNGEncSlice *sl = &s->slices[i];
+        uint8_t *buf    = sl->buf;
+
+        if (sl->size < 0)
+            return sl->size;
+
+        rows = pict->height * (i + 1) / nb_bands - pict->height * i / nb_bands;
+        adler = i ? adler32_combine(adler, sl->adler, (z_off_t)rows * (row_size + 1))
+                  : sl->adler;
+
+        size = sl->size;
+        if (!i) {
+            memmove(buf + 2, buf, size);
+            AV_WB16(buf, s->zlib_header);
+            size += 2;
+        }
+        if (i == nb_bands - 1) {
+            AV_WB32(buf + size, adler);
+            size += 4;
+        }
+        if (s->bytestream_end - s->bytestream < size + 100)
+            return AVERROR_BUG;
+        png_write_image_data(avctx, buf, size);
+    }
+
+    return 0;
+}
+
 static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
 {
     PNGEncContext *s       = avctx->priv_data;
@@ -439,6 +561,12 @@ static int encode_frame(AVCodecContext *avctx, const AVFrame *pict)
     uint8_t *progressive_buf = NULL;
     uint8_t *top_buf         = NULL;
 
+    if (s->nb_slices) {
+        int nb_bands = FFMIN(s->nb_slices, pict->height / MIN_BAND_HEIGHT);
+        if (nb_bands > 1)
+            return encode_frame_slices(avctx, pict, nb_bands);
+    }
+
     row_size = (pict->width * s->bits_per_pixel + 7) >> 3;
 
     crow_base = av_malloc((row_size + 32) << (s->filter_type == PNG_FILTER_VALUE_MIXED));
@@ -1092,14 +1220,53 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if (deflateInit2(&s->zstream, compression_level, Z_DEFLATED, 15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
         return -1;
 
+    if (avctx->active_thread_type & FF_THREAD_SLICE && !s->is_progressive) {
+        int level = compression_level == Z_DEFAULT_COMPRESSION ? 6 : compression_level;
+        int i;
+
+        /* same header as zlib writes for a 32K window */
+        s->zlib_header  = (Z_DEFLATED + (7 << 4)) << 8;
+        s->zlib_header |= (level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6;
+        s->zlib_header += 31 - s->zlib_header % 31;
+
+        s->slices = av_mallocz_array(avctx->thread_count, sizeof(*s->slices));
+        if (!s->slices)
+            return AVERROR(ENOMEM);
+        for (i = 0; i < avctx->thread_count; i++) {
+            PNGEncSlice *sl = &s->slices[i];
+
+            sl->crow_base = av_malloc((((avctx->width * s->bits_per_pixel + 7) >> 3) + 32)
+                                      << (s->filter_type == PNG_FILTER_VALUE_MIXED));
+            if (!sl->crow_base)
+                return AVERROR(ENOMEM);
+            sl->zstream.zalloc = ff_png_zalloc;
+            sl->zstream.zfree  = ff_png_zfree;
+            sl->zstream.opaque = NULL;
+            if (deflateInit2(&sl->zstream, compression_level, Z_DEFLATED, -15, 8,
+                             Z_DEFAULT_STRATEGY) != Z_OK) {
+                av_freep(&sl->crow_base);
+                return -1;
+            }
+            s->nb_slices++;
+        }
+    }
+
     return 0;
 }
 
 static av_cold int png_enc_close(AVCodecContext *avctx)
 {
     PNGEncContext *s = avctx->priv_data;
+    int i;
 
     deflateEnd(&s->zstream);
+    for (i = 0; i < s->nb_slices; i++) {
+        deflateEnd(&s->slices[i].zstream);
+        av_freep(&s->slices[i].crow_base);
+        av_freep(&s->slices[i].buf);
+    }
+    av_freep(&s->slices);
+    s->nb_slices = 0;
     av_frame_free(&s->last_frame);
     av_frame_free(&s->prev_frame);
     av_freep(&s->last_frame_packet);
@@ -1146,7 +1313,9 @@ AVCodec ff_png_encoder = {
     .init           = png_enc_init,
     .close          = png_enc_close,
     .encode2        = encode_png,
-    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_INTRA_ONLY,
+    .capabilities   = AV_CODEC_CAP_FRAME_THREADS | AV_CODEC_CAP_SLICE_THREADS |
+                      AV_CODEC_CAP_INTRA_ONLY,
+    .caps_internal  = FF_CODEC_CAP_INIT_CLEANUP,
     .pix_fmts       = (const enum AVPixelFormat[]) {
         AV_PIX_FMT_RGB24, AV_PIX_FMT_RGBA,
         AV_PIX_FMT_RGB48BE, AV_PIX_FMT_RGBA64BE,
@@ -674,6 +674,10 @@ void ff_frame_thread_free(AVCodecContext *avctx, int thread_count)
             pthread_join(p->thread, NULL);
         p->thread_init=0;
 
+        if (p->avctx && p->avctx->internal &&
+            p->avctx->internal->slice_thread_ctx)
+            ff_slice_thread_free(p->avctx);
+
         if (codec->close && p->avctx)
             codec->close(p->avctx);
 
@@ -799,6 +803,9 @@ int ff_frame_thread_init(AVCodecContext *avctx)
         }
         *copy->internal = *src->internal;
         copy->internal->thread_ctx = p;
+        copy->internal->slice_thread_ctx = NULL;
+        copy->execute  = avctx->execute;
+        copy->execute2 = avctx->execute2;
         copy->internal->last_pkt_props = &p->avpkt;
 
         if (!i) {
@@ -135,6 +135,17 @@ int ff_thread_ref_frame(ThreadFrame *dst, ThreadFrame *src);
 int ff_thread_init(AVCodecContext *s);
 void ff_thread_free(AVCodecContext *s);
 
+/**
+ * Start a slice thread pool on a frame thread context, so that the
+ * execute() and execute2() calls of each frame thread run in parallel.
+ * Must be called from the codec init() or init_thread_copy(); the pool is
+ * freed together with the frame thread.
+ *
+ * @param thread_count number of slice threads, nothing is done if <= 1
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_slice_thread_init_nested(AVCodecContext *avctx, int thread_count);
+
 int ff_alloc_entries(AVCodecContext *avctx, int count);
 void ff_reset_entries(AVCodecContext *avctx);
 void ff_thread_report_progress2(AVCodecContext *avctx, int field, int thread, int n);
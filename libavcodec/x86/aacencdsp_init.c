@@ -23,7 +23,7 @@
 
 #include "libavutil/float_dsp.h"
 #include "libavutil/x86/cpu.h"
-#include "libavcodec/aacenc.h"
+#include "libavcodec/aacencdsp.h"
 
 void ff_abs_pow34_sse(float *out, const float *in, const int size);
 
@@ -31,7 +31,7 @@ void ff_aac_quantize_bands_sse2(int *out, const float *in, const float *scaled,
                                 int size, int is_signed, int maxval, const float Q34,
                                 const float rounding);
 
-av_cold void ff_aac_dsp_init_x86(AACEncContext *s)
+av_cold void ff_aacenc_dsp_init_x86(AACEncDSPContext *s)
 {
     int cpu_flags = av_get_cpu_flags();
 
@@ -77,6 +77,12 @@ static void lpc_apply_welch_window_sse2(const int32_t *data, int len,
                                     "%xmm5", "%xmm6", "%xmm7")
     );
 #undef WELCH
+    /* with len / 2 odd the two halves overlap in the middle and the last
+     * store of the right one puts the weight of w_data[n2] in w_data[n2-1] */
+    if ((len & 3) == 2) {
+        double w = c - n2;
+        w_data[n2-1] = data[n2-1] * (1.0 - w * w);
+    }
 }
 
 static void lpc_compute_autocorr_sse2(const double *data, int len, int lag,
@@ -149,14 +155,95 @@ static void lpc_compute_autocorr_sse2(const double *data, int len, int lag,
 
 #endif /* HAVE_SSE2_INLINE */
 
+#if HAVE_AVX_INLINE
+
+/* first n lanes set, see lpc_compute_autocorr_avx() */
+static const int64_t autocorr_mask[7] = { -1, -1, -1, 0, 0, 0, 0 };
+
+/* Computes 4 lags per pass. Each pass starts at data[j], so at most 3
+ * samples preceding data are read, and the last len - j & 3 samples are
+ * read with masked loads, so nothing is read past data[len - 1]. */
+static void lpc_compute_autocorr_avx(const double *data, int len, int lag,
+                                     double *autoc)
+{
+    int j, k;
+
+    for (j = 0; j <= lag; j += 4) {
+        double sum[4];
+        int n = FFMAX(len - j, 0);
+        const double *end = data + j + (n & ~3);
+        x86_reg i = -(x86_reg)(n & ~3) * sizeof(double);
+
+        __asm__ volatile(
+            "vxorpd      %%ymm0, %%ymm0, %%ymm0     \n\t"
+            "vxorpd      %%ymm1, %%ymm1, %%ymm1     \n\t"
+            "vxorpd      %%ymm2, %%ymm2, %%ymm2     \n\t"
+            "vxorpd      %%ymm3, %%ymm3, %%ymm3     \n\t"
+            "test        %0,     %0                 \n\t"
+            "jz 2f                                  \n\t"
+            "1:                                     \n\t"
+            "vmovupd       (%1,%0), %%ymm4          \n\t"
+            "vmulpd        (%2,%0), %%ymm4, %%ymm5  \n\t"
+            "vaddpd      %%ymm5, %%ymm0, %%ymm0     \n\t"
+            "vmulpd      -8(%2,%0), %%ymm4, %%ymm5  \n\t"
+            "vaddpd      %%ymm5, %%ymm1, %%ymm1     \n\t"
+            "vmulpd     -16(%2,%0), %%ymm4, %%ymm5  \n\t"
+            "vaddpd      %%ymm5, %%ymm2, %%ymm2     \n\t"
+            "vmulpd     -24(%2,%0), %%ymm4, %%ymm5  \n\t"
+            "vaddpd      %%ymm5, %%ymm3, %%ymm3     \n\t"
+            "add         $32,    %0                 \n\t"
+            "jl 1b                                  \n\t"
+            "2:                                     \n\t"
+            "vmovupd       (%3), %%ymm6             \n\t"
+            "vmaskmovpd    (%1), %%ymm6, %%ymm4     \n\t"
+            "vmaskmovpd    (%2), %%ymm6, %%ymm5     \n\t"
+            "vmulpd      %%ymm4, %%ymm5, %%ymm5     \n\t"
+            "vaddpd      %%ymm5, %%ymm0, %%ymm0     \n\t"
+            "vmaskmovpd  -8(%2), %%ymm6, %%ymm5     \n\t"
+            "vmulpd      %%ymm4, %%ymm5, %%ymm5     \n\t"
+            "vaddpd      %%ymm5, %%ymm1, %%ymm1     \n\t"
+            "vmaskmovpd -16(%2), %%ymm6, %%ymm5     \n\t"
+            "vmulpd      %%ymm4, %%ymm5, %%ymm5     \n\t"
+            "vaddpd      %%ymm5, %%ymm2, %%ymm2     \n\t"
+            "vmaskmovpd -24(%2), %%ymm6, %%ymm5     \n\t"
+            "vmulpd      %%ymm4, %%ymm5, %%ymm5     \n\t"
+            "vaddpd      %%ymm5, %%ymm3, %%ymm3     \n\t"
+            "vhaddpd     %%ymm1, %%ymm0, %%ymm0     \n\t"
+            "vhaddpd     %%ymm3, %%ymm2, %%ymm2     \n\t"
+            "vperm2f128  $0x20, %%ymm2, %%ymm0, %%ymm4 \n\t"
+            "vperm2f128  $0x31, %%ymm2, %%ymm0, %%ymm5 \n\t"
+            "vaddpd      %%ymm5, %%ymm4, %%ymm4     \n\t"
+            "vmovupd     %%ymm4, (%4)               \n\t"
+            "vzeroupper                             \n\t"
+            :"+&r"(i)
+            :"r"(end), "r"(end - j), "r"(autocorr_mask + 3 - (n & 3)), "r"(sum)
+            : XMM_CLOBBERS("%xmm0", "%xmm1", "%xmm2", "%xmm3",
+                           "%xmm4", "%xmm5", "%xmm6",)
+              "memory"
+        );
+
+        for (k = 0; k < 4 && j + k <= lag; k++)
+            autoc[j + k] = sum[k] + 1.0;
+    }
+}
+
+#endif /* HAVE_AVX_INLINE */
+
 av_cold void ff_lpc_init_x86(LPCContext *c)
 {
-#if HAVE_SSE2_INLINE
+#if HAVE_INLINE_ASM
     int cpu_flags = av_get_cpu_flags();
 
+#if HAVE_SSE2_INLINE
     if (INLINE_SSE2(cpu_flags) || INLINE_SSE2_SLOW(cpu_flags)) {
         c->lpc_apply_welch_window = lpc_apply_welch_window_sse2;
         c->lpc_compute_autocorr   = lpc_compute_autocorr_sse2;
     }
 #endif /* HAVE_SSE2_INLINE */
+
+#if HAVE_AVX_INLINE
+    if (INLINE_AVX(cpu_flags))
+        c->lpc_compute_autocorr   = lpc_compute_autocorr_avx;
+#endif /* HAVE_AVX_INLINE */
+#endif /* HAVE_INLINE_ASM */
 }
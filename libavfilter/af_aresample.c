@@ -348,4 +348,5 @@ AVFilter ff_af_aresample = {
     .priv_class    = &aresample_class,
     .inputs        = aresample_inputs,
     .outputs       = aresample_outputs,
+    .flags_internal = FF_FILTER_FLAG_FRAME_THREADS,
 };
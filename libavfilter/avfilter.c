@@ -660,6 +660,7 @@ static const AVOption avfilter_options[] = {
     { "thread_type", "Allowed thread types", OFFSET(thread_type), AV_OPT_TYPE_FLAGS,
         { .i64 = AVFILTER_THREAD_SLICE }, 0, INT_MAX, FLAGS, "thread_type" },
         { "slice", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_SLICE }, .unit = "thread_type" },
+        { "frame", NULL, 0, AV_OPT_TYPE_CONST, { .i64 = AVFILTER_THREAD_FRAME }, .unit = "thread_type" },
     { "enable", "set enable expression", OFFSET(enable_str), AV_OPT_TYPE_STRING, {.str=NULL}, .flags = FLAGS },
     { "threads", "Allowed number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, FLAGS },
@@ -824,6 +825,9 @@ void avfilter_free(AVFilterContext *filter)
     av_expr_free(filter->enable);
     filter->enable = NULL;
     av_freep(&filter->var_values);
+    for (i = 0; i < filter->internal->nb_deferred_frames; i++)
+        av_frame_free(&filter->internal->deferred_frames[i].frame);
+    av_freep(&filter->internal->deferred_frames);
     av_freep(&filter->internal);
     av_free(filter);
 }
@@ -922,7 +926,7 @@ int avfilter_init_filter(AVFilterContext *filter, const char *args, void *opaque
 
 int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
 {
-    int ret = 0;
+    int ret = 0, thread_type;
 
     ret = av_opt_set_dict(ctx, options);
     if (ret < 0) {
@@ -930,14 +934,18 @@ int avfilter_init_dict(AVFilterContext *ctx, AVDictionary **options)
         return ret;
     }
 
+    thread_type      = ctx->thread_type & ctx->graph->thread_type;
+    ctx->thread_type = 0;
     if (ctx->filter->flags & AVFILTER_FLAG_SLICE_THREADS &&
-        ctx->thread_type & ctx->graph->thread_type & AVFILTER_THREAD_SLICE &&
+        thread_type & AVFILTER_THREAD_SLICE &&
         ctx->graph->internal->thread_execute) {
-        ctx->thread_type       = AVFILTER_THREAD_SLICE;
+        ctx->thread_type      |= AVFILTER_THREAD_SLICE;
         ctx->internal->execute = ctx->graph->internal->thread_execute;
-    } else {
-        ctx->thread_type = 0;
     }
+    if (ctx->filter->flags_internal & FF_FILTER_FLAG_FRAME_THREADS &&
+        thread_type & AVFILTER_THREAD_FRAME &&
+        ctx->graph->internal->thread_execute)
+        ctx->thread_type |= AVFILTER_THREAD_FRAME;
 
     if (ctx->filter->priv_class) {
         ret = av_opt_set_dict(ctx->priv, options);
@@ -1091,9 +1099,16 @@ static int default_filter_frame(AVFilterLink *link, AVFrame *frame)
     return ff_filter_frame(link->dst->outputs[0], frame);
 }
 
-static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
+typedef int (*filter_frame_func)(AVFilterLink *link, AVFrame *frame);
+
+/**
+ * Do the common processing before delivering a frame to a filter and
+ * select the callback to deliver it with. The frame is freed on failure.
+ */
+static int filter_frame_prepare(AVFilterLink *link, AVFrame **frame,
+                                filter_frame_func *rfilter_frame)
 {
-    int (*filter_frame)(AVFilterLink *, AVFrame *);
+    filter_frame_func filter_frame;
     AVFilterContext *dstctx = link->dst;
     AVFilterPad *dst = link->dstpad;
     int ret;
@@ -1102,24 +1117,55 @@ static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
         filter_frame = default_filter_frame;
 
     if (dst->needs_writable) {
-        ret = ff_inlink_make_frame_writable(link, &frame);
+        ret = ff_inlink_make_frame_writable(link, frame);
         if (ret < 0)
             goto fail;
     }
 
-    ff_inlink_process_commands(link, frame);
-    dstctx->is_disabled = !ff_inlink_evaluate_timeline_at_frame(link, frame);
+    ff_inlink_process_commands(link, *frame);
+    dstctx->is_disabled = !ff_inlink_evaluate_timeline_at_frame(link, *frame);
 
     if (dstctx->is_disabled &&
         (dstctx->filter->flags & AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC))
         filter_frame = default_filter_frame;
+    *rfilter_frame = filter_frame;
+    return 0;
+
+fail:
+    av_frame_free(frame);
+    return ret;
+}
+
+static int ff_filter_frame_framed(AVFilterLink *link, AVFrame *frame)
+{
+    filter_frame_func filter_frame;
+    int ret;
+
+    ret = filter_frame_prepare(link, &frame, &filter_frame);
+    if (ret < 0)
+        return ret;
     ret = filter_frame(link, frame);
     link->frame_count_out++;
     return ret;
+}
 
-fail:
-    av_frame_free(&frame);
-    return ret;
+static int defer_frame(AVFilterLink *link, AVFrame *frame)
+{
+    AVFilterInternal *internal = link->src->internal;
+    FFDeferredFrame *deferred;
+
+    deferred = av_fast_realloc(internal->deferred_frames,
+                               &internal->deferred_frames_size,
+                               (internal->nb_deferred_frames + 1) * sizeof(*deferred));
+    if (!deferred) {
+        av_frame_free(&frame);
+        return AVERROR(ENOMEM);
+    }
+    internal->deferred_frames = deferred;
+    deferred[internal->nb_deferred_frames].link  = link;
+    deferred[internal->nb_deferred_frames].frame = frame;
+    internal->nb_deferred_frames++;
+    return 0;
 }
 
 int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
@@ -1127,6 +1173,9 @@ int ff_filter_frame(AVFilterLink *link, AVFrame *frame)
     int ret;
     FF_TPRINTF_START(NULL, filter_frame); ff_tlog_link(NULL, link, 1); ff_tlog(NULL, " "); ff_tlog_ref(NULL, frame, 1);
 
+    if (link->src->internal->deferred)
+        return defer_frame(link, frame);
+
     /* Consistency checks */
     if (link->type == AVMEDIA_TYPE_VIDEO) {
         if (strcmp(link->dst->filter->name, "buffersink") &&
@@ -1240,35 +1289,49 @@ static int take_samples(AVFilterLink *link, unsigned min, unsigned max,
     return 0;
 }
 
-static int ff_filter_frame_to_filter(AVFilterLink *link)
+static int filter_frame_consume(AVFilterLink *link, AVFrame **rframe)
 {
-    AVFrame *frame = NULL;
-    AVFilterContext *dst = link->dst;
     int ret;
 
     av_assert1(ff_framequeue_queued_frames(&link->fifo));
     ret = link->min_samples ?
-          ff_inlink_consume_samples(link, link->min_samples, link->max_samples, &frame) :
-          ff_inlink_consume_frame(link, &frame);
+          ff_inlink_consume_samples(link, link->min_samples, link->max_samples, rframe) :
+          ff_inlink_consume_frame(link, rframe);
     av_assert1(ret);
     if (ret < 0) {
-        av_assert1(!frame);
+        av_assert1(!*rframe);
         return ret;
     }
     /* The filter will soon have received a new frame, that may allow it to
        produce one or more: unblock its outputs. */
-    filter_unblock(dst);
+    filter_unblock(link->dst);
     /* AVFilterPad.filter_frame() expect frame_count_out to have the value
        before the frame; ff_filter_frame_framed() will re-increment it. */
     link->frame_count_out--;
-    ret = ff_filter_frame_framed(link, frame);
+    return 0;
+}
+
+static void filter_frame_done(AVFilterLink *link, int ret)
+{
     if (ret < 0 && ret != link->status_out) {
         ff_avfilter_link_set_out_status(link, ret, AV_NOPTS_VALUE);
     } else {
         /* Run once again, to see if several frames were available, or if
            the input status has also changed, or any other reason. */
-        ff_filter_set_ready(dst, 300);
+        ff_filter_set_ready(link->dst, 300);
     }
+}
+
+static int ff_filter_frame_to_filter(AVFilterLink *link)
+{
+    AVFrame *frame = NULL;
+    int ret;
+
+    ret = filter_frame_consume(link, &frame);
+    if (ret < 0)
+        return ret;
+    ret = ff_filter_frame_framed(link, frame);
+    filter_frame_done(link, ret);
     return ret;
 }
 
@@ -1480,6 +1543,140 @@ int ff_filter_activate(AVFilterContext *filter)
     return ret;
 }
 
+#define MAX_FRAME_THREAD_JOBS 32
+
+typedef struct FrameThreadJob {
+    AVFilterLink *link;
+    AVFrame *frame;
+    filter_frame_func filter_frame;
+    avfilter_execute_func *execute;
+    int ret;
+} FrameThreadJob;
+
+static int frame_thread_candidate(AVFilterContext *filter)
+{
+    AVFilterLink *inlink;
+    unsigned i;
+
+    if (!filter->ready || !(filter->thread_type & AVFILTER_THREAD_FRAME) ||
+        filter->filter->activate || filter->nb_inputs != 1 || !filter->nb_outputs)
+        return 0;
+    inlink = filter->inputs[0];
+    if (!samples_ready(inlink, inlink->min_samples))
+        return 0;
+    /* allocating a frame on an output must not reach into the next filter */
+    for (i = 0; i < filter->nb_outputs; i++) {
+        AVFilterLink *outlink = filter->outputs[i];
+        if (!outlink || outlink->dstpad->get_video_buffer ||
+            outlink->dstpad->get_audio_buffer)
+            return 0;
+    }
+    return 1;
+}
+
+static int frame_thread_adjacent(AVFilterContext *a, AVFilterContext *b)
+{
+    unsigned i;
+
+    for (i = 0; i < a->nb_inputs; i++)
+        if (a->inputs[i] && a->inputs[i]->src == b)
+            return 1;
+    for (i = 0; i < a->nb_outputs; i++)
+        if (a->outputs[i] && a->outputs[i]->dst == b)
+            return 1;
+    return 0;
+}
+
+static int frame_thread_worker(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    FrameThreadJob *job = (FrameThreadJob *)arg + jobnr;
+
+    if (job->filter_frame)
+        job->ret = job->filter_frame(job->link, job->frame);
+    return 0;
+}
+
+int ff_filter_activate_frame_threads(AVFilterGraph *graph, AVFilterContext *filter)
+{
+    FrameThreadJob jobs[MAX_FRAME_THREAD_JOBS];
+    unsigned i, j, nb_jobs = 0;
+    int ret = 0, err;
+
+    if (!frame_thread_candidate(filter))
+        return 0;
+    jobs[nb_jobs++].link = filter->inputs[0];
+
+    for (i = 0; i < graph->nb_filters && nb_jobs < MAX_FRAME_THREAD_JOBS; i++) {
+        AVFilterContext *f = graph->filters[i];
+
+        if (f == filter || !frame_thread_candidate(f))
+            continue;
+        for (j = 0; j < nb_jobs; j++)
+            if (frame_thread_adjacent(f, jobs[j].link->dst))
+                break;
+        if (j == nb_jobs)
+            jobs[nb_jobs++].link = f->inputs[0];
+    }
+    if (nb_jobs < 2)
+        return 0;
+
+    /* Take the frames from the links and do the bookkeeping serially, this
+       touches the state of the neighbouring filters. */
+    for (i = 0; i < nb_jobs; i++) {
+        FrameThreadJob *job = &jobs[i];
+        AVFilterContext *dst = job->link->dst;
+
+        dst->ready        = 0;
+        job->frame        = NULL;
+        job->filter_frame = NULL;
+        job->ret = filter_frame_consume(job->link, &job->frame);
+        if (job->ret < 0) {
+            job->link = NULL;
+            continue;
+        }
+        job->ret = filter_frame_prepare(job->link, &job->frame, &job->filter_frame);
+        if (job->ret < 0)
+            continue;
+
+        /* the worker threads are busy running the filters themselves */
+        job->execute           = dst->internal->execute;
+        dst->internal->execute = default_execute;
+        dst->internal->deferred = 1;
+    }
+
+    graph->internal->thread_execute(filter, frame_thread_worker, jobs, NULL, nb_jobs);
+
+    for (i = 0; i < nb_jobs; i++) {
+        FrameThreadJob *job = &jobs[i];
+
+        if (job->filter_frame) {
+            AVFilterInternal *internal = job->link->dst->internal;
+
+            internal->deferred = 0;
+            internal->execute  = job->execute;
+            job->link->frame_count_out++;
+            /* keep the first error, drop the frames queued after it */
+            for (j = 0; j < internal->nb_deferred_frames; j++) {
+                FFDeferredFrame *deferred = &internal->deferred_frames[j];
+                if (job->ret < 0) {
+                    av_frame_free(&deferred->frame);
+                    continue;
+                }
+                err = ff_filter_frame(deferred->link, deferred->frame);
+                if (err < 0)
+                    job->ret = err;
+            }
+            internal->nb_deferred_frames = 0;
+        }
+        if (job->link)
+            filter_frame_done(job->link, job->ret);
+        if (job->ret < 0 && !ret)
+            ret = job->ret;
+    }
+
+    return ret < 0 ? ret : nb_jobs;
+}
+
 int ff_inlink_acknowledge_status(AVFilterLink *link, int *rstatus, int64_t *rpts)
 {
     *rpts = link->current_pts;
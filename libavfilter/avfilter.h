@@ -316,6 +316,12 @@ typedef struct AVFilter {
  * Process multiple parts of the frame concurrently.
  */
 #define AVFILTER_THREAD_SLICE (1 << 0)
+/**
+ * Process frames in independent filters of the graph concurrently.
+ * Not enabled by default, it must be set in both AVFilterGraph.thread_type
+ * and AVFilterContext.thread_type.
+ */
+#define AVFILTER_THREAD_FRAME (1 << 1)
 
 typedef struct AVFilterInternal AVFilterInternal;
 
@@ -344,8 +350,8 @@ struct AVFilterContext {
      * AVFILTER_THREAD_* flags.
      *
      * May be set by the caller before initializing the filter to forbid some
-     * or all kinds of multithreading for this filter. The default is allowing
-     * everything.
+     * or all kinds of multithreading for this filter. The default is
+     * AVFILTER_THREAD_SLICE, AVFILTER_THREAD_FRAME must be enabled explicitly.
      *
      * When the filter is initialized, this field is combined using bit AND with
      * AVFilterGraph.thread_type to get the final mask used for determining
@@ -852,7 +858,8 @@ typedef struct AVFilterGraph {
      * of AVFILTER_THREAD_* flags.
      *
      * May be set by the caller at any point, the setting will apply to all
-     * filters initialized after that. The default is allowing everything.
+     * filters initialized after that. The default is AVFILTER_THREAD_SLICE,
+     * AVFILTER_THREAD_FRAME must be enabled explicitly.
      *
      * When a filter in this graph is initialized, this field is combined using
      * bit AND with AVFilterContext.thread_type to get the final mask used for
@@ -151,8 +151,23 @@ struct AVFilterGraphInternal {
     FFFrameQueueGlobal frame_queues;
 };
 
+typedef struct FFDeferredFrame {
+    AVFilterLink *link;
+    AVFrame *frame;
+} FFDeferredFrame;
+
 struct AVFilterInternal {
     avfilter_execute_func *execute;
+
+    /**
+     * Set while the filter runs concurrently with other filters of the
+     * graph: frames sent on its outputs are kept in deferred_frames and
+     * only pushed to the links once all the filters are done.
+     */
+    int deferred;
+    FFDeferredFrame *deferred_frames;
+    unsigned nb_deferred_frames;
+    unsigned deferred_frames_size;
 };
 
 /**
@@ -392,6 +407,28 @@ void ff_filter_graph_remove_filter(AVFilterGraph *graph, AVFilterContext *filter
  */
 #define FF_FILTER_FLAG_HWFRAME_AWARE (1 << 0)
 
+/**
+ * The filter can process a frame concurrently with other filters of the
+ * graph (AVFILTER_THREAD_FRAME). It must have a single input and use the
+ * legacy filter_frame() callback, which may only access the filter's own
+ * state and links, allocate frames on its outputs and send frames with
+ * ff_filter_frame().
+ */
+#define FF_FILTER_FLAG_FRAME_THREADS (1 << 1)
+
+/**
+ * Activate several ready filters of the graph concurrently, if possible.
+ *
+ * Only filters supporting AVFILTER_THREAD_FRAME with a frame available on
+ * their input are considered, and no two adjacent filters are run at the
+ * same time.
+ *
+ * @param filter the filter that would be activated next; it must be ready
+ * @return the number of filters activated, 0 if fewer than two could run
+ *         concurrently (nothing was done), or a negative error code
+ */
+int ff_filter_activate_frame_threads(AVFilterGraph *graph, AVFilterContext *filter);
+
 /**
  * Run one round of processing on a filter graph.
  */
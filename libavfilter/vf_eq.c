@@ -386,4 +386,5 @@ AVFilter ff_vf_eq = {
     .init            = initialize,
     .uninit          = uninit,
     .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags_internal  = FF_FILTER_FLAG_FRAME_THREADS,
 };
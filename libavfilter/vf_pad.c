@@ -320,11 +320,76 @@ static int frame_needs_copy(PadContext *s, AVFrame *frame)
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int needs_copy;
+} ThreadData;
+
+/**
+ * Fill the borders and copy the input for the output rows of slice jobnr.
+ * Slices are aligned on the chroma subsampling.
+ */
+static int pad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PadContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *in  = td->in;
+    AVFrame *out = td->out;
+    const int align = 1 << s->draw.vsub_max;
+    const int rows  = s->h / align;
+    int slice_start = rows *  jobnr      / nb_jobs * align;
+    int slice_end   = rows * (jobnr + 1) / nb_jobs * align;
+    int start, end;
+
+    if (jobnr == nb_jobs - 1)
+        slice_end = s->h;
+
+    /* top bar */
+    end = FFMIN(slice_end, s->y);
+    if (slice_start < end) {
+        ff_fill_rectangle(&s->draw, &s->color,
+                          out->data, out->linesize,
+                          0, slice_start, s->w, end - slice_start);
+    }
+
+    /* bottom bar */
+    start = FFMAX(slice_start, s->y + s->in_h);
+    if (start < slice_end) {
+        ff_fill_rectangle(&s->draw, &s->color,
+                          out->data, out->linesize,
+                          0, start, s->w, slice_end - start);
+    }
+
+    start = FFMAX(slice_start, s->y);
+    end   = FFMIN(slice_end, s->y + in->height);
+    if (start >= end)
+        return 0;
+
+    /* left border */
+    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
+                      0, start, s->x, end - start);
+
+    if (td->needs_copy) {
+        ff_copy_rectangle2(&s->draw,
+                          out->data, out->linesize, in->data, in->linesize,
+                          s->x, start, 0, start - s->y, in->width, end - start);
+    }
+
+    /* right border */
+    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
+                      s->x + s->in_w, start, s->w - s->x - s->in_w,
+                      end - start);
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     PadContext *s = inlink->dst->priv;
+    AVFilterContext *ctx = inlink->dst;
     AVFilterLink *outlink = inlink->dst->outputs[0];
     AVFrame *out;
+    ThreadData td;
     int needs_copy;
     if(s->eval_mode == EVAL_MODE_FRAME && (
            in->width  != s->inlink_w
@@ -376,34 +441,12 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
         }
     }
 
-    /* top bar */
-    if (s->y) {
-        ff_fill_rectangle(&s->draw, &s->color,
-                          out->data, out->linesize,
-                          0, 0, s->w, s->y);
-    }
-
-    /* bottom bar */
-    if (s->h > s->y + s->in_h) {
-        ff_fill_rectangle(&s->draw, &s->color,
-                          out->data, out->linesize,
-                          0, s->y + s->in_h, s->w, s->h - s->y - s->in_h);
-    }
-
-    /* left border */
-    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
-                      0, s->y, s->x, in->height);
-
-    if (needs_copy) {
-        ff_copy_rectangle2(&s->draw,
-                          out->data, out->linesize, in->data, in->linesize,
-                          s->x, s->y, 0, 0, in->width, in->height);
-    }
-
-    /* right border */
-    ff_fill_rectangle(&s->draw, &s->color, out->data, out->linesize,
-                      s->x + s->in_w, s->y, s->w - s->x - s->in_w,
-                      in->height);
+    td.in         = in;
+    td.out        = out;
+    td.needs_copy = needs_copy;
+    ctx->internal->execute(ctx, pad_slice, &td, NULL,
+                           FFMIN(FFMAX(s->h >> s->draw.vsub_max, 1),
+                                 ff_filter_get_nb_threads(ctx)));
 
     out->width  = s->w;
     out->height = s->h;
@@ -461,4 +504,5 @@ AVFilter ff_vf_pad = {
     .query_formats = query_formats,
     .inputs        = avfilter_vf_pad_inputs,
     .outputs       = avfilter_vf_pad_outputs,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
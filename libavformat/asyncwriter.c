@@ -0,0 +1,386 @@
+/*
+ * Asynchronous output for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+
+#if HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "libavutil/avstring.h"
+#include "libavutil/fifo.h"
+#include "libavutil/thread.h"
+
+#include "asyncwriter.h"
+#include "avformat.h"
+#include "internal.h"
+#include "os_support.h"
+
+#define ASYNC_BUFFER_SIZE 32768
+
+#if HAVE_THREADS
+
+enum AsyncRequestType {
+    ASYNC_OPEN,
+    ASYNC_WRITE,
+    ASYNC_CLOSE,
+    ASYNC_DELETE,
+    ASYNC_RENAME,
+};
+
+typedef struct AsyncFile {
+    AsyncWriter *w;
+    char *url;
+    AVDictionary *options;
+    AVIOContext *pb;            ///< actual output, only used by the writer thread
+} AsyncFile;
+
+typedef struct AsyncRequest {
+    enum AsyncRequestType type;
+    AsyncFile *file;
+    uint8_t *data;
+    int size;
+    char *path, *new_path;
+} AsyncRequest;
+
+struct AsyncWriter {
+    AVFormatContext *s;
+    AVFifoBuffer *queue;
+    int pending;                ///< requests queued or being performed
+    int error;                  ///< first error of the writer thread
+    int finish;
+
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+};
+
+static int perform_request(AsyncWriter *w, AsyncRequest *req)
+{
+    AVFormatContext *s = w->s;
+    AsyncFile *f = req->file;
+    int ret = 0;
+
+    switch (req->type) {
+    case ASYNC_OPEN:
+        ret = s->io_open(s, &f->pb, f->url, AVIO_FLAG_WRITE, &f->options);
+        if (ret < 0)
+            av_log(s, AV_LOG_ERROR, "Failed to open %s: %s\n",
+                   f->url, av_err2str(ret));
+        break;
+    case ASYNC_WRITE:
+        /* the error was reported when opening */
+        if (f->pb) {
+            avio_write(f->pb, req->data, req->size);
+            avio_flush(f->pb);
+            ret = f->pb->error;
+        }
+        av_free(req->data);
+        break;
+    case ASYNC_CLOSE:
+        if (f->pb) {
+            avio_flush(f->pb);
+            ret = f->pb->error;
+            ff_format_io_close(s, &f->pb);
+        }
+        av_free(f->url);
+        av_dict_free(&f->options);
+        av_free(f);
+        break;
+    case ASYNC_DELETE:
+        if (unlink(req->path) < 0)
+            av_log(s, AV_LOG_ERROR, "failed to delete %s: %s\n",
+                   req->path, strerror(errno));
+        av_free(req->path);
+        break;
+    case ASYNC_RENAME:
+        ret = ff_rename(req->path, req->new_path, s);
+        av_free(req->path);
+        av_free(req->new_path);
+        break;
+    }
+
+    return ret;
+}
+
+static void *async_writer_thread(void *arg)
+{
+    AsyncWriter *w = arg;
+    AsyncRequest req;
+    int ret;
+
+    pthread_mutex_lock(&w->mutex);
+    for (;;) {
+        while (!av_fifo_size(w->queue) && !w->finish)
+            pthread_cond_wait(&w->cond, &w->mutex);
+        if (!av_fifo_size(w->queue))
+            break;
+        av_fifo_generic_read(w->queue, &req, sizeof(req), NULL);
+        pthread_mutex_unlock(&w->mutex);
+
+        ret = perform_request(w, &req);
+
+        pthread_mutex_lock(&w->mutex);
+        if (ret < 0 && !w->error)
+            w->error = ret;
+        w->pending--;
+        pthread_cond_broadcast(&w->cond);
+    }
+    pthread_mutex_unlock(&w->mutex);
+
+    return NULL;
+}
+
+/* Queue a request, waiting for room if needed. The request is always
+ * queued, so that the resources it carries are freed by the writer. */
+static int queue_request(AsyncWriter *w, const AsyncRequest *req)
+{
+    int ret;
+
+    pthread_mutex_lock(&w->mutex);
+    while (av_fifo_space(w->queue) < sizeof(*req))
+        pthread_cond_wait(&w->cond, &w->mutex);
+    av_fifo_generic_write(w->queue, (void *)req, sizeof(*req), NULL);
+    w->pending++;
+    ret = w->error;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+
+    return ret;
+}
+
+static int async_write_packet(void *opaque, uint8_t *buf, int size)
+{
+    AsyncFile *f = opaque;
+    AsyncRequest req = { ASYNC_WRITE, f };
+    int ret;
+
+    if (!(req.data = av_memdup(buf, size)))
+        return AVERROR(ENOMEM);
+    req.size = size;
+
+    ret = queue_request(f->w, &req);
+    return ret < 0 ? ret : size;
+}
+
+int ff_async_writer_alloc(AsyncWriter **pw, AVFormatContext *s, int queue_size)
+{
+    AsyncWriter *w;
+    int ret;
+
+    if (!(w = av_mallocz(sizeof(*w))))
+        return AVERROR(ENOMEM);
+    w->s = s;
+    if (!(w->queue = av_fifo_alloc_array(queue_size, sizeof(AsyncRequest)))) {
+        av_free(w);
+        return AVERROR(ENOMEM);
+    }
+    pthread_mutex_init(&w->mutex, NULL);
+    pthread_cond_init(&w->cond, NULL);
+
+    ret = pthread_create(&w->thread, NULL, async_writer_thread, w);
+    if (ret) {
+        av_log(s, AV_LOG_ERROR, "pthread_create failed: %s\n", av_err2str(AVERROR(ret)));
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->mutex);
+        av_fifo_freep(&w->queue);
+        av_free(w);
+        return AVERROR(ret);
+    }
+
+    *pw = w;
+    return 0;
+}
+
+int ff_async_writer_free(AsyncWriter **pw)
+{
+    AsyncWriter *w = *pw;
+    int ret;
+
+    if (!w)
+        return 0;
+
+    pthread_mutex_lock(&w->mutex);
+    w->finish = 1;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+    pthread_join(w->thread, NULL);
+
+    ret = w->error;
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->mutex);
+    av_fifo_freep(&w->queue);
+    av_freep(pw);
+
+    return ret;
+}
+
+int ff_async_writer_open(AsyncWriter *w, AVIOContext **pb, const char *url,
+                         AVDictionary **options)
+{
+    AsyncRequest req = { ASYNC_OPEN };
+    AsyncFile *f;
+    uint8_t *buf;
+    int ret;
+
+    pthread_mutex_lock(&w->mutex);
+    ret = w->error;
+    pthread_mutex_unlock(&w->mutex);
+    if (ret < 0)
+        return ret;
+
+    f   = av_mallocz(sizeof(*f));
+    buf = av_malloc(ASYNC_BUFFER_SIZE);
+    if (!f || !buf)
+        goto fail;
+    f->w = w;
+    if (!(f->url = av_strdup(url)))
+        goto fail;
+    if (options && av_dict_copy(&f->options, *options, 0) < 0)
+        goto fail;
+
+    *pb = avio_alloc_context(buf, ASYNC_BUFFER_SIZE, 1, f, NULL,
+                             async_write_packet, NULL);
+    if (!*pb)
+        goto fail;
+    (*pb)->seekable = 0;
+
+    req.file = f;
+    queue_request(w, &req);
+    return 0;
+
+fail:
+    if (f) {
+        av_free(f->url);
+        av_dict_free(&f->options);
+    }
+    av_free(f);
+    av_free(buf);
+    return AVERROR(ENOMEM);
+}
+
+int ff_async_writer_close(AsyncWriter *w, AVIOContext **pb)
+{
+    AsyncRequest req = { ASYNC_CLOSE };
+
+    if (!*pb)
+        return 0;
+
+    avio_flush(*pb);
+    req.file = (*pb)->opaque;
+    av_freep(&(*pb)->buffer);
+    av_freep(pb);
+
+    return queue_request(w, &req);
+}
+
+int ff_async_writer_delete(AsyncWriter *w, const char *path)
+{
+    AsyncRequest req = { ASYNC_DELETE };
+
+    if (!(req.path = av_strdup(path)))
+        return AVERROR(ENOMEM);
+    return queue_request(w, &req);
+}
+
+int ff_async_writer_rename(AsyncWriter *w, const char *oldpath,
+                           const char *newpath)
+{
+    AsyncRequest req = { ASYNC_RENAME };
+
+    req.path     = av_strdup(oldpath);
+    req.new_path = av_strdup(newpath);
+    if (!req.path || !req.new_path) {
+        av_free(req.path);
+        av_free(req.new_path);
+        return AVERROR(ENOMEM);
+    }
+    return queue_request(w, &req);
+}
+
+int ff_async_writer_flush(AsyncWriter *w)
+{
+    int ret;
+
+    pthread_mutex_lock(&w->mutex);
+    while (w->pending)
+        pthread_cond_wait(&w->cond, &w->mutex);
+    ret = w->error;
+    pthread_mutex_unlock(&w->mutex);
+
+    return ret;
+}
+
+int ff_async_writer_queue_depth(AsyncWriter *w)
+{
+    int depth;
+
+    pthread_mutex_lock(&w->mutex);
+    depth = w->pending;
+    pthread_mutex_unlock(&w->mutex);
+
+    return depth;
+}
+
+#else
+
+int ff_async_writer_alloc(AsyncWriter **w, AVFormatContext *s, int queue_size)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_async_writer_free(AsyncWriter **w)
+{
+    return 0;
+}
+
+int ff_async_writer_open(AsyncWriter *w, AVIOContext **pb, const char *url,
+                         AVDictionary **options)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_async_writer_close(AsyncWriter *w, AVIOContext **pb)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_async_writer_delete(AsyncWriter *w, const char *path)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_async_writer_rename(AsyncWriter *w, const char *oldpath,
+                           const char *newpath)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_async_writer_flush(AsyncWriter *w)
+{
+    return AVERROR(ENOSYS);
+}
+
+int ff_async_writer_queue_depth(AsyncWriter *w)
+{
+    return 0;
+}
+
+#endif /* HAVE_THREADS */
@@ -0,0 +1,85 @@
+/*
+ * Asynchronous output for segmenting muxers
+ *
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFORMAT_ASYNCWRITER_H
+#define AVFORMAT_ASYNCWRITER_H
+
+#include "avformat.h"
+
+/**
+ * Writer thread performing the output file operations of a muxer in the
+ * order they were requested. The muxer only blocks when the queue of pending
+ * requests is full.
+ */
+typedef struct AsyncWriter AsyncWriter;
+
+/**
+ * Start a writer thread for the muxer s. Files are opened and closed with
+ * the io_open and io_close callbacks of s, from the writer thread.
+ *
+ * @param queue_size maximum number of pending requests
+ * @return 0 on success, AVERROR(ENOSYS) if threads are not available
+ */
+int ff_async_writer_alloc(AsyncWriter **w, AVFormatContext *s, int queue_size);
+
+/**
+ * Wait for the pending requests to complete and stop the writer.
+ *
+ * @return the first error that occurred on the writer thread, if any
+ */
+int ff_async_writer_free(AsyncWriter **w);
+
+/**
+ * Open url for writing. The returned AVIOContext is not seekable, its
+ * writes are queued and it must be closed with ff_async_writer_close().
+ * Data flushed from it is flushed to the output once it has been written.
+ *
+ * @return a negative error code if a previous request failed
+ */
+int ff_async_writer_open(AsyncWriter *w, AVIOContext **pb, const char *url,
+                         AVDictionary **options);
+
+/**
+ * Queue the close of a file opened with ff_async_writer_open() and free pb.
+ */
+int ff_async_writer_close(AsyncWriter *w, AVIOContext **pb);
+
+/**
+ * Queue the removal of a local file.
+ */
+int ff_async_writer_delete(AsyncWriter *w, const char *path);
+
+/**
+ * Queue the renaming of a local file.
+ */
+int ff_async_writer_rename(AsyncWriter *w, const char *oldpath,
+                           const char *newpath);
+
+/**
+ * Wait until all the queued requests have been performed.
+ */
+int ff_async_writer_flush(AsyncWriter *w);
+
+/**
+ * @return the number of requests queued or being performed
+ */
+int ff_async_writer_queue_depth(AsyncWriter *w);
+
+#endif /* AVFORMAT_ASYNCWRITER_H */
@@ -32,6 +32,7 @@
 #include "libavutil/rational.h"
 #include "libavutil/time_internal.h"
 
+#include "asyncwriter.h"
 #include "avc.h"
 #include "avformat.h"
 #include "avio_internal.h"
@@ -72,6 +73,9 @@ typedef struct OutputStream {
     Segment **segments;
     int64_t first_pts, start_pts, max_pts;
     int64_t last_dts;
+    int64_t chunk_start_pts;
+    int chunks_written;         ///< chunks of the current segment already written out
+    int64_t seg_start_pos;
     int bit_rate;
     char bandwidth_str[64];
 
@@ -99,8 +103,51 @@ typedef struct DASHContext {
     AVRational min_frame_rate, max_frame_rate;
     int ambiguous_frame_rate;
     const char *utc_timing_url;
+    int streaming;
+    int64_t frag_duration;
+    int async_queue_size;
+    int async_queue_depth;
+    AsyncWriter *writer;
 } DASHContext;
 
+static int dashenc_io_open(AVFormatContext *s, AVIOContext **pb, const char *filename)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->writer)
+        return ff_async_writer_open(c->writer, pb, filename, NULL);
+    return s->io_open(s, pb, filename, AVIO_FLAG_WRITE, NULL);
+}
+
+static void dashenc_io_close(AVFormatContext *s, AVIOContext **pb)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->writer)
+        ff_async_writer_close(c->writer, pb);
+    else
+        ff_format_io_close(s, pb);
+}
+
+static int dashenc_move(AVFormatContext *s, const char *oldpath, const char *newpath)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->writer)
+        return ff_async_writer_rename(c->writer, oldpath, newpath);
+    return avpriv_io_move(oldpath, newpath);
+}
+
+static void dashenc_delete(AVFormatContext *s, const char *filename)
+{
+    DASHContext *c = s->priv_data;
+
+    if (c->writer)
+        ff_async_writer_delete(c->writer, filename);
+    else
+        unlink(filename);
+}
+
 static int dash_write(void *opaque, uint8_t *buf, int buf_size)
 {
     OutputStream *os = opaque;
@@ -187,7 +234,7 @@ static void dash_free(AVFormatContext *s)
             av_write_trailer(os->ctx);
         if (os->ctx && os->ctx->pb)
             av_free(os->ctx->pb);
-        ff_format_io_close(s, &os->out);
+        dashenc_io_close(s, &os->out);
         if (os->ctx)
             avformat_free_context(os->ctx);
         for (j = 0; j < os->nb_segments; j++)
@@ -195,6 +242,22 @@ static void dash_free(AVFormatContext *s)
         av_free(os->segments);
     }
     av_freep(&c->streams);
+    ff_async_writer_free(&c->writer);
+}
+
+static void write_availability_time_offset(AVIOContext *out, DASHContext *c)
+{
+    int64_t chunk_duration = c->frag_duration;
+
+    if (!c->streaming)
+        return;
+    // Without an explicit chunk duration, every frame is a chunk.
+    if (!chunk_duration && c->max_frame_rate.num)
+        chunk_duration = av_rescale(AV_TIME_BASE, c->max_frame_rate.den, c->max_frame_rate.num);
+    if (chunk_duration >= c->min_seg_duration)
+        return;
+    avio_printf(out, "availabilityTimeOffset=\"%.3f\" ",
+                (double)(c->min_seg_duration - chunk_duration) / AV_TIME_BASE);
 }
 
 static void output_segment_list(OutputStream *os, AVIOContext *out, DASHContext *c)
@@ -210,6 +273,7 @@ static void output_segment_list(OutputStream *os, AVIOContext *out, DASHContext
         avio_printf(out, "\t\t\t\t<SegmentTemplate timescale=\"%d\" ", timescale);
         if (!c->use_timeline)
             avio_printf(out, "duration=\"%"PRId64"\" ", c->last_duration);
+        write_availability_time_offset(out, c);
         avio_printf(out, "initialization=\"%s\" media=\"%s\" startNumber=\"%d\">\n", c->init_seg_name, c->media_seg_name, c->use_timeline ? start_number : 1);
         if (c->use_timeline) {
             int64_t cur_time = 0;
@@ -238,7 +302,9 @@ static void output_segment_list(OutputStream *os, AVIOContext *out, DASHContext
         avio_printf(out, "\t\t\t\t</SegmentTemplate>\n");
     } else if (c->single_file) {
         avio_printf(out, "\t\t\t\t<BaseURL>%s</BaseURL>\n", os->initfile);
-        avio_printf(out, "\t\t\t\t<SegmentList timescale=\"%d\" duration=\"%"PRId64"\" startNumber=\"%d\">\n", AV_TIME_BASE, c->last_duration, start_number);
+        avio_printf(out, "\t\t\t\t<SegmentList timescale=\"%d\" duration=\"%"PRId64"\" ", AV_TIME_BASE, c->last_duration);
+        write_availability_time_offset(out, c);
+        avio_printf(out, "startNumber=\"%d\">\n", start_number);
         avio_printf(out, "\t\t\t\t\t<Initialization range=\"%"PRId64"-%"PRId64"\" />\n", os->init_start_pos, os->init_start_pos + os->init_range_length - 1);
         for (i = start_index; i < os->nb_segments; i++) {
             Segment *seg = os->segments[i];
@@ -249,7 +315,9 @@ static void output_segment_list(OutputStream *os, AVIOContext *out, DASHContext
         }
         avio_printf(out, "\t\t\t\t</SegmentList>\n");
     } else {
-        avio_printf(out, "\t\t\t\t<SegmentList timescale=\"%d\" duration=\"%"PRId64"\" startNumber=\"%d\">\n", AV_TIME_BASE, c->last_duration, start_number);
+        avio_printf(out, "\t\t\t\t<SegmentList timescale=\"%d\" duration=\"%"PRId64"\" ", AV_TIME_BASE, c->last_duration);
+        write_availability_time_offset(out, c);
+        avio_printf(out, "startNumber=\"%d\">\n", start_number);
         avio_printf(out, "\t\t\t\t\t<Initialization sourceURL=\"%s\" />\n", os->initfile);
         for (i = start_index; i < os->nb_segments; i++) {
             Segment *seg = os->segments[i];
@@ -454,7 +522,7 @@ static int write_manifest(AVFormatContext *s, int final)
         av_log(s, AV_LOG_ERROR, "Cannot use rename on non file protocol, this may lead to races and temporary partial files\n");
 
     snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", s->filename);
-    ret = s->io_open(s, &out, temp_filename, AVIO_FLAG_WRITE, NULL);
+    ret = dashenc_io_open(s, &out, temp_filename);
     if (ret < 0) {
         av_log(s, AV_LOG_ERROR, "Unable to open %s for writing\n", temp_filename);
         return ret;
@@ -557,10 +625,10 @@ static int write_manifest(AVFormatContext *s, int final)
     avio_printf(out, "\t</Period>\n");
     avio_printf(out, "</MPD>\n");
     avio_flush(out);
-    ff_format_io_close(s, &out);
+    dashenc_io_close(s, &out);
 
     if (use_rename)
-        return avpriv_io_move(temp_filename, s->filename);
+        return dashenc_move(s, temp_filename, s->filename);
 
     return 0;
 }
@@ -629,6 +697,15 @@ static int dash_init(AVFormatContext *s)
     if (ret < 0)
         return ret;
 
+    if (c->async_queue_size > 0) {
+        ret = ff_async_writer_alloc(&c->writer, s, c->async_queue_size);
+        if (ret == AVERROR(ENOSYS))
+            av_log(s, AV_LOG_WARNING, "Asynchronous output requires threads, "
+                   "writing synchronously\n");
+        else if (ret < 0)
+            return ret;
+    }
+
     for (i = 0; i < s->nb_streams; i++) {
         OutputStream *os = &c->streams[i];
         AVFormatContext *ctx;
@@ -667,7 +744,7 @@ static int dash_init(AVFormatContext *s)
             dash_fill_tmpl_params(os->initfile, sizeof(os->initfile), c->init_seg_name, i, 0, os->bit_rate, 0);
         }
         snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->initfile);
-        ret = s->io_open(s, &os->out, filename, AVIO_FLAG_WRITE, NULL);
+        ret = dashenc_io_open(s, &os->out, filename);
         if (ret < 0)
             return ret;
         os->init_start_pos = 0;
@@ -705,6 +782,7 @@ static int dash_init(AVFormatContext *s)
         os->first_pts = AV_NOPTS_VALUE;
         os->max_pts = AV_NOPTS_VALUE;
         os->last_dts = AV_NOPTS_VALUE;
+        os->chunk_start_pts = AV_NOPTS_VALUE;
         os->segment_index = 1;
     }
 
@@ -822,6 +900,18 @@ static int update_stream_extradata(AVFormatContext *s, OutputStream *os,
     return 0;
 }
 
+static void write_init_segment(AVFormatContext *s, OutputStream *os)
+{
+    DASHContext *c = s->priv_data;
+
+    if (os->init_range_length)
+        return;
+    av_write_frame(os->ctx, NULL);
+    os->init_range_length = avio_tell(os->ctx->pb);
+    if (!c->single_file)
+        dashenc_io_close(s, &os->out);
+}
+
 static int dash_flush(AVFormatContext *s, int final, int stream)
 {
     DASHContext *c = s->priv_data;
@@ -855,23 +945,24 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
                 continue;
         }
 
-        if (!os->init_range_length) {
-            av_write_frame(os->ctx, NULL);
-            os->init_range_length = avio_tell(os->ctx->pb);
-            if (!c->single_file)
-                ff_format_io_close(s, &os->out);
-        }
+        write_init_segment(s, os);
 
-        start_pos = avio_tell(os->ctx->pb);
+        // In streaming mode, the segment was opened by its first chunk.
+        if (os->chunks_written)
+            start_pos = os->seg_start_pos;
+        else
+            start_pos = avio_tell(os->ctx->pb);
 
         if (!c->single_file) {
             dash_fill_tmpl_params(filename, sizeof(filename), c->media_seg_name, i, os->segment_index, os->bit_rate, os->start_pts);
             snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, filename);
-            snprintf(temp_path, sizeof(temp_path), use_rename ? "%s.tmp" : "%s", full_path);
-            ret = s->io_open(s, &os->out, temp_path, AVIO_FLAG_WRITE, NULL);
-            if (ret < 0)
-                break;
-            write_styp(os->ctx->pb);
+            if (!os->chunks_written) {
+                snprintf(temp_path, sizeof(temp_path), use_rename ? "%s.tmp" : "%s", full_path);
+                ret = dashenc_io_open(s, &os->out, temp_path);
+                if (ret < 0)
+                    break;
+                write_styp(os->ctx->pb);
+            }
         } else {
             snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, os->initfile);
         }
@@ -882,16 +973,23 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
 
         range_length = avio_tell(os->ctx->pb) - start_pos;
         if (c->single_file) {
+            if (c->writer) {
+                // The segment is read back, wait until it reaches the file.
+                avio_flush(os->out);
+                ff_async_writer_flush(c->writer);
+            }
             find_index_range(s, full_path, start_pos, &index_length);
         } else {
-            ff_format_io_close(s, &os->out);
+            dashenc_io_close(s, &os->out);
 
-            if (use_rename) {
-                ret = avpriv_io_move(temp_path, full_path);
+            if (use_rename && !os->chunks_written) {
+                ret = dashenc_move(s, temp_path, full_path);
                 if (ret < 0)
                     break;
             }
         }
+        os->chunks_written  = 0;
+        os->chunk_start_pts = AV_NOPTS_VALUE;
         add_segment(os, filename, os->start_pts, os->max_pts - os->start_pts, start_pos, range_length, index_length);
         av_log(s, AV_LOG_VERBOSE, "Representation %d media segment %d written to: %s\n", i, os->segment_index, full_path);
     }
@@ -907,7 +1005,7 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
                 for (j = 0; j < remove; j++) {
                     char filename[1024];
                     snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->segments[j]->file);
-                    unlink(filename);
+                    dashenc_delete(s, filename);
                     av_free(os->segments[j]);
                 }
                 os->nb_segments -= remove;
@@ -921,6 +1019,43 @@ static int dash_flush(AVFormatContext *s, int final, int stream)
     return ret;
 }
 
+/**
+ * Write out the fragment buffered for a stream as a chunk of its current
+ * segment, opening the segment first if needed.
+ */
+static int dash_flush_chunk(AVFormatContext *s, int stream)
+{
+    DASHContext *c = s->priv_data;
+    OutputStream *os = &c->streams[stream];
+    int ret;
+
+    write_init_segment(s, os);
+
+    if (!os->chunks_written) {
+        os->seg_start_pos = avio_tell(os->ctx->pb);
+        if (!c->single_file) {
+            char filename[1024], full_path[1024];
+
+            dash_fill_tmpl_params(filename, sizeof(filename), c->media_seg_name, stream, os->segment_index, os->bit_rate, os->start_pts);
+            snprintf(full_path, sizeof(full_path), "%s%s", c->dirname, filename);
+            // Clients fetch the segment while it is written, so it can't be
+            // written to a temporary file first.
+            ret = dashenc_io_open(s, &os->out, full_path);
+            if (ret < 0)
+                return ret;
+            write_styp(os->ctx->pb);
+        }
+    }
+
+    av_write_frame(os->ctx, NULL);
+    avio_flush(os->ctx->pb);
+    avio_flush(os->out);
+    os->chunks_written++;
+    os->chunk_start_pts = AV_NOPTS_VALUE;
+
+    return 0;
+}
+
 static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
 {
     DASHContext *c = s->priv_data;
@@ -993,7 +1128,19 @@ static int dash_write_packet(AVFormatContext *s, AVPacket *pkt)
     else
         os->max_pts = FFMAX(os->max_pts, pkt->pts + pkt->duration);
     os->packets_written++;
-    return ff_write_chained(os->ctx, 0, pkt, s, 0);
+    if (os->chunk_start_pts == AV_NOPTS_VALUE)
+        os->chunk_start_pts = pkt->pts;
+    if (c->writer)
+        c->async_queue_depth = ff_async_writer_queue_depth(c->writer);
+    if ((ret = ff_write_chained(os->ctx, 0, pkt, s, 0)) < 0)
+        return ret;
+
+    if (c->streaming &&
+        av_compare_ts(os->max_pts - os->chunk_start_pts, st->time_base,
+                      c->frag_duration, AV_TIME_BASE_Q) >= 0)
+        ret = dash_flush_chunk(s, pkt->stream_index);
+
+    return ret;
 }
 
 static int dash_write_trailer(AVFormatContext *s)
@@ -1022,11 +1169,14 @@ static int dash_write_trailer(AVFormatContext *s)
         for (i = 0; i < s->nb_streams; i++) {
             OutputStream *os = &c->streams[i];
             snprintf(filename, sizeof(filename), "%s%s", c->dirname, os->initfile);
-            unlink(filename);
+            dashenc_delete(s, filename);
         }
-        unlink(s->filename);
+        dashenc_delete(s, s->filename);
     }
 
+    if (c->writer)
+        return ff_async_writer_flush(c->writer);
+
     return 0;
 }
 
@@ -1067,6 +1217,10 @@ static const AVOption options[] = {
     { "init_seg_name", "DASH-templated name to used for the initialization segment", OFFSET(init_seg_name), AV_OPT_TYPE_STRING, {.str = "init-stream$RepresentationID$.m4s"}, 0, 0, E },
     { "media_seg_name", "DASH-templated name to used for the media segments", OFFSET(media_seg_name), AV_OPT_TYPE_STRING, {.str = "chunk-stream$RepresentationID$-$Number%05d$.m4s"}, 0, 0, E },
     { "utc_timing_url", "URL of the page that will return the UTC timestamp in ISO format", OFFSET(utc_timing_url), AV_OPT_TYPE_STRING, { 0 }, 0, 0, E },
+    { "streaming", "Write segments as chunks of fragments while they are produced, for low latency", OFFSET(streaming), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, E },
+    { "frag_duration", "minimum duration of the chunks in streaming mode (in microseconds), 0 for one chunk per frame", OFFSET(frag_duration), AV_OPT_TYPE_INT64, { .i64 = 0 }, 0, INT64_MAX, E },
+    { "async_queue_size", "write segments and manifests from a separate thread, with at most this many pending operations", OFFSET(async_queue_size), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX / 64, E },
+    { "async_queue_depth", "number of pending output operations", OFFSET(async_queue_depth), AV_OPT_TYPE_INT, { .i64 = 0 }, 0, INT_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { NULL },
 };
 
@@ -32,6 +32,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/dict.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "avformat.h"
 #include "internal.h"
@@ -76,6 +77,20 @@ struct segment {
     struct segment *init_section;
 };
 
+/*
+ * A segment downloaded by the prefetch thread. If the Media Initialization
+ * Section changed, it is stored at the start of the data.
+ */
+struct prefetch_segment {
+    uint8_t *data;
+    unsigned int alloc_size;
+    int size;           /* bytes downloaded so far */
+    int init_size;      /* size of the initialization section in data */
+    int pos;            /* read position */
+    int seq_no;
+    int done;           /* no more data will be added */
+};
+
 struct rendition;
 
 enum PlaylistType {
@@ -153,6 +168,28 @@ struct playlist {
      * playlist, if any. */
     int n_init_sections;
     struct segment **init_sections;
+
+#if HAVE_THREADS
+    /* Segment prefetching. While the thread runs it owns the segment
+     * downloads and the live playlist reloads; prefetch_segs is a ring of
+     * HLSContext.prefetch + 1 segments, the first one being read by
+     * read_data(). The mutex protects the ring and the segment list. */
+    pthread_t prefetch_thread;
+    pthread_mutex_t prefetch_mutex;
+    pthread_cond_t prefetch_cond;
+    struct prefetch_segment *prefetch_segs;
+    int prefetch_head;
+    int prefetch_count;
+    int prefetch_seq_no;    /* first segment downloaded by the thread */
+    int prefetch_started;
+    int prefetch_abort;
+    int prefetch_finished;  /* the thread has no more segments to add */
+    int prefetch_error;     /* AVERROR_EOF or the error that stopped it */
+    int prefetch_reading;   /* the head segment is being read */
+    /* Opens the URLs of the thread while it runs, its interrupt callback
+     * also checks prefetch_abort so that stop_prefetch() wakes up I/O. */
+    AVFormatContext *prefetch_io;
+#endif
 };
 
 /*
@@ -205,8 +242,53 @@ typedef struct HLSContext {
     AVDictionary *avio_opts;
     int strict_std_compliance;
     char *allowed_extensions;
+    int prefetch;
+#if HAVE_THREADS
+    pthread_mutex_t cookies_mutex;       ///< protects cookies from concurrent prefetch threads
+#endif
 } HLSContext;
 
+static void lock_cookies(HLSContext *c)
+{
+#if HAVE_THREADS
+    if (c->prefetch > 0)
+        pthread_mutex_lock(&c->cookies_mutex);
+#endif
+}
+
+static void unlock_cookies(HLSContext *c)
+{
+#if HAVE_THREADS
+    if (c->prefetch > 0)
+        pthread_mutex_unlock(&c->cookies_mutex);
+#endif
+}
+
+static void lock_playlist(struct playlist *pls)
+{
+#if HAVE_THREADS
+    if (pls->prefetch_segs)
+        pthread_mutex_lock(&pls->prefetch_mutex);
+#endif
+}
+
+static void unlock_playlist(struct playlist *pls)
+{
+#if HAVE_THREADS
+    if (pls->prefetch_segs)
+        pthread_mutex_unlock(&pls->prefetch_mutex);
+#endif
+}
+
+static int is_prefetching(struct playlist *pls)
+{
+#if HAVE_THREADS
+    return pls->prefetch_started;
+#else
+    return 0;
+#endif
+}
+
 static int read_chomp_line(AVIOContext *s, char *buf, int maxlen)
 {
     int len = ff_get_line(s, buf, maxlen);
@@ -238,11 +320,14 @@ static void free_init_section_list(struct playlist *pls)
     pls->n_init_sections = 0;
 }
 
+static void free_prefetch(struct playlist *pls);
+
 static void free_playlist_list(HLSContext *c)
 {
     int i;
     for (i = 0; i < c->n_playlists; i++) {
         struct playlist *pls = c->playlists[i];
+        free_prefetch(pls);
         free_segment_list(pls);
         free_init_section_list(pls);
         av_freep(&pls->main_streams);
@@ -596,8 +681,19 @@ static void update_options(char **dest, const char *name, void *src)
         av_freep(dest);
 }
 
-static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
-                    AVDictionary *opts, AVDictionary *opts2, int *is_http)
+/* The context the URLs of a playlist are opened with. */
+static AVFormatContext *playlist_io(HLSContext *c, struct playlist *pls)
+{
+#if HAVE_THREADS
+    if (pls && pls->prefetch_io)
+        return pls->prefetch_io;
+#endif
+    return c->ctx;
+}
+
+static int open_url(AVFormatContext *s, AVFormatContext *io, AVIOContext **pb,
+                    const char *url, AVDictionary *opts, AVDictionary *opts2,
+                    int *is_http)
 {
     HLSContext *c = s->priv_data;
     AVDictionary *tmp = NULL;
@@ -639,7 +735,7 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
     else if (strcmp(proto_name, "file") || !strncmp(url, "file,", 5))
         return AVERROR_INVALIDDATA;
 
-    ret = s->io_open(s, pb, url, AVIO_FLAG_READ, &tmp);
+    ret = io->io_open(io, pb, url, AVIO_FLAG_READ, &tmp);
     if (ret >= 0) {
         // update cookies on http response with setcookies.
         char *new_cookies = NULL;
@@ -647,12 +743,14 @@ static int open_url(AVFormatContext *s, AVIOContext **pb, const char *url,
         if (!(s->flags & AVFMT_FLAG_CUSTOM_IO))
             av_opt_get(*pb, "cookies", AV_OPT_SEARCH_CHILDREN, (uint8_t**)&new_cookies);
 
+        lock_cookies(c);
         if (new_cookies) {
             av_free(c->cookies);
             c->cookies = new_cookies;
         }
 
         av_dict_set(&opts, "cookies", c->cookies, 0);
+        unlock_cookies(c);
     }
 
     av_dict_free(&tmp);
@@ -681,6 +779,7 @@ static int parse_playlist(HLSContext *c, const char *url,
     struct variant_info variant_info;
     char tmp_str[MAX_URL_SIZE];
     struct segment *cur_init_section = NULL;
+    AVFormatContext *io = playlist_io(c, pls);
 
     if (!in) {
 #if 1
@@ -691,11 +790,13 @@ static int parse_playlist(HLSContext *c, const char *url,
 
         // broker prior HTTP options that should be consistent across requests
         av_dict_set(&opts, "user_agent", c->user_agent, 0);
+        lock_cookies(c);
         av_dict_set(&opts, "cookies", c->cookies, 0);
+        unlock_cookies(c);
         av_dict_set(&opts, "headers", c->headers, 0);
         av_dict_set(&opts, "http_proxy", c->http_proxy, 0);
 
-        ret = c->ctx->io_open(c->ctx, &in, url, AVIO_FLAG_READ, &opts);
+        ret = io->io_open(io, &in, url, AVIO_FLAG_READ, &opts);
         av_dict_free(&opts);
         if (ret < 0)
             return ret;
@@ -863,7 +964,7 @@ static int parse_playlist(HLSContext *c, const char *url,
 fail:
     av_free(new_url);
     if (close_in)
-        ff_format_io_close(c->ctx, &in);
+        ff_format_io_close(io, &in);
     return ret;
 }
 
@@ -900,6 +1001,41 @@ static int read_from_url(struct playlist *pls, struct segment *seg,
     return ret;
 }
 
+#if HAVE_THREADS
+/* Read from the segment being read in the prefetch ring, 0 means its end. */
+static int read_prefetched(struct playlist *pls, uint8_t *buf, int buf_size,
+                           enum ReadFromURLMode mode)
+{
+    struct prefetch_segment *ps = &pls->prefetch_segs[pls->prefetch_head];
+    int size;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    while (!ps->done && (ps->size - ps->pos < buf_size &&
+                         (mode == READ_COMPLETE || ps->size == ps->pos)))
+        pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_mutex);
+    size = FFMIN(buf_size, ps->size - ps->pos);
+    memcpy(buf, ps->data + ps->pos, size);
+    ps->pos += size;
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    if (mode == READ_COMPLETE && size != buf_size)
+        av_log(NULL, AV_LOG_ERROR, "Could not read complete segment.\n");
+
+    return size;
+}
+#endif
+
+static int read_segment_data(struct playlist *pls, struct segment *seg,
+                             uint8_t *buf, int buf_size,
+                             enum ReadFromURLMode mode)
+{
+#if HAVE_THREADS
+    if (pls->prefetch_started)
+        return read_prefetched(pls, buf, buf_size, mode);
+#endif
+    return read_from_url(pls, seg, buf, buf_size, mode);
+}
+
 /* Parse the raw ID3 data and pass contents to caller */
 static void parse_id3(AVFormatContext *s, AVIOContext *pb,
                       AVDictionary **metadata, int64_t *dts,
@@ -1005,13 +1141,14 @@ static void intercept_id3(struct playlist *pls, uint8_t *buf,
     int bytes;
     int id3_buf_pos = 0;
     int fill_buf = 0;
-    struct segment *seg = current_segment(pls);
+    /* the segment list belongs to the prefetch thread when there is one */
+    struct segment *seg = is_prefetching(pls) ? NULL : current_segment(pls);
 
     /* gather all the id3 tags */
     while (1) {
         /* see if we can retrieve enough data for ID3 header */
         if (*len < ID3v2_HEADER_SIZE && buf_size >= ID3v2_HEADER_SIZE) {
-            bytes = read_from_url(pls, seg, buf + *len, ID3v2_HEADER_SIZE - *len, READ_COMPLETE);
+            bytes = read_segment_data(pls, seg, buf + *len, ID3v2_HEADER_SIZE - *len, READ_COMPLETE);
             if (bytes > 0) {
 
                 if (bytes == ID3v2_HEADER_SIZE - *len)
@@ -1032,7 +1169,7 @@ static void intercept_id3(struct playlist *pls, uint8_t *buf,
             break;
 
         if (ff_id3v2_match(buf, ID3v2_DEFAULT_MAGIC)) {
-            int64_t maxsize = seg->size >= 0 ? seg->size : 1024*1024;
+            int64_t maxsize = seg && seg->size >= 0 ? seg->size : 1024*1024;
             int taglen = ff_id3v2_tag_len(buf);
             int tag_got_bytes = FFMIN(taglen, *len);
             int remaining = taglen - tag_got_bytes;
@@ -1063,7 +1200,7 @@ static void intercept_id3(struct playlist *pls, uint8_t *buf,
 
             if (remaining > 0) {
                 /* read the rest of the tag in */
-                if (read_from_url(pls, seg, pls->id3_buf + id3_buf_pos, remaining, READ_COMPLETE) != remaining)
+                if (read_segment_data(pls, seg, pls->id3_buf + id3_buf_pos, remaining, READ_COMPLETE) != remaining)
                     break;
                 id3_buf_pos += remaining;
                 av_log(pls->ctx, AV_LOG_DEBUG, "Stripped additional %d HLS ID3 bytes\n", remaining);
@@ -1077,7 +1214,7 @@ static void intercept_id3(struct playlist *pls, uint8_t *buf,
 
     /* re-fill buffer for the caller unless EOF */
     if (*len >= 0 && (fill_buf || *len == 0)) {
-        bytes = read_from_url(pls, seg, buf + *len, buf_size - *len, READ_NORMAL);
+        bytes = read_segment_data(pls, seg, buf + *len, buf_size - *len, READ_NORMAL);
 
         /* ignore error if we already had some data */
         if (bytes >= 0)
@@ -1100,12 +1237,15 @@ static void intercept_id3(struct playlist *pls, uint8_t *buf,
 static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg)
 {
     AVDictionary *opts = NULL;
+    AVFormatContext *io = playlist_io(c, pls);
     int ret;
     int is_http = 0;
 
     // broker prior HTTP options that should be consistent across requests
     av_dict_set(&opts, "user_agent", c->user_agent, 0);
+    lock_cookies(c);
     av_dict_set(&opts, "cookies", c->cookies, 0);
+    unlock_cookies(c);
     av_dict_set(&opts, "headers", c->headers, 0);
     av_dict_set(&opts, "http_proxy", c->http_proxy, 0);
     av_dict_set(&opts, "seekable", "0", 0);
@@ -1121,19 +1261,19 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg)
            seg->url, seg->url_offset, pls->index);
 
     if (seg->key_type == KEY_NONE) {
-        ret = open_url(pls->parent, &pls->input, seg->url, c->avio_opts, opts, &is_http);
+        ret = open_url(pls->parent, io, &pls->input, seg->url, c->avio_opts, opts, &is_http);
     } else if (seg->key_type == KEY_AES_128) {
         AVDictionary *opts2 = NULL;
         char iv[33], key[33], url[MAX_URL_SIZE];
         if (strcmp(seg->key, pls->key_url)) {
             AVIOContext *pb;
-            if (open_url(pls->parent, &pb, seg->key, c->avio_opts, opts, NULL) == 0) {
+            if (open_url(pls->parent, io, &pb, seg->key, c->avio_opts, opts, NULL) == 0) {
                 ret = avio_read(pb, pls->key, sizeof(pls->key));
                 if (ret != sizeof(pls->key)) {
                     av_log(NULL, AV_LOG_ERROR, "Unable to read key file %s\n",
                            seg->key);
                 }
-                ff_format_io_close(pls->parent, &pb);
+                ff_format_io_close(io, &pb);
             } else {
                 av_log(NULL, AV_LOG_ERROR, "Unable to open key file %s\n",
                        seg->key);
@@ -1152,7 +1292,7 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg)
         av_dict_set(&opts2, "key", key, 0);
         av_dict_set(&opts2, "iv", iv, 0);
 
-        ret = open_url(pls->parent, &pls->input, url, opts2, opts, &is_http);
+        ret = open_url(pls->parent, io, &pls->input, url, opts2, opts, &is_http);
 
         av_dict_free(&opts2);
 
@@ -1183,7 +1323,7 @@ static int open_input(HLSContext *c, struct playlist *pls, struct segment *seg)
         if (seekret < 0) {
             av_log(pls->parent, AV_LOG_ERROR, "Unable to seek to offset %"PRId64" of HLS segment '%s'\n", seg->url_offset, seg->url);
             ret = seekret;
-            ff_format_io_close(pls->parent, &pls->input);
+            ff_format_io_close(io, &pls->input);
         }
     }
 
@@ -1234,7 +1374,7 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
 
     ret = read_from_url(pls, seg->init_section, pls->init_sec_buf,
                         pls->init_sec_buf_size, READ_COMPLETE);
-    ff_format_io_close(pls->parent, &pls->input);
+    ff_format_io_close(playlist_io(c, pls), &pls->input);
 
     if (ret < 0)
         return ret;
@@ -1243,10 +1383,6 @@ static int update_init_section(struct playlist *pls, struct segment *seg)
     pls->init_sec_data_len = ret;
     pls->init_sec_buf_read_offset = 0;
 
-    /* spec says audio elementary streams do not have media initialization
-     * sections, so there should be no ID3 timestamps */
-    pls->is_id3_timestamped = 0;
-
     return 0;
 }
 
@@ -1257,37 +1393,444 @@ static int64_t default_reload_interval(struct playlist *pls)
                           pls->target_duration;
 }
 
+/* Check that the playlist is still needed before opening a new segment. */
+static int playlist_needed(struct playlist *v)
+{
+    int i;
+
+    if (v->ctx && v->ctx->nb_streams) {
+        v->needed = 0;
+        for (i = 0; i < v->n_main_streams; i++) {
+            if (v->main_streams[i]->discard < AVDISCARD_ALL) {
+                v->needed = 1;
+                break;
+            }
+        }
+    }
+    if (!v->needed)
+        av_log(v->parent, AV_LOG_INFO, "No longer receiving playlist %d\n",
+               v->index);
+
+    return v->needed;
+}
+
+#if HAVE_THREADS
+static int prefetch_aborted(struct playlist *pls)
+{
+    int abort;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    abort = pls->prefetch_abort;
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    return abort;
+}
+
+static int prefetch_interrupt_cb(void *opaque)
+{
+    struct playlist *pls = opaque;
+    HLSContext *c = pls->parent->priv_data;
+
+    return prefetch_aborted(pls) || ff_check_interrupt(c->interrupt_callback);
+}
+
+/* Create the context the prefetch thread opens its URLs with. */
+static int alloc_prefetch_io(struct playlist *pls)
+{
+    AVFormatContext *s = pls->parent, *io;
+
+    if (!(io = avformat_alloc_context()))
+        return AVERROR(ENOMEM);
+    io->iformat  = s->iformat;
+    io->flags    = s->flags;
+    io->opaque   = s->opaque;
+    io->io_open  = s->io_open;
+    io->io_close = s->io_close;
+    io->interrupt_callback.callback = prefetch_interrupt_cb;
+    io->interrupt_callback.opaque   = pls;
+    av_strlcpy(io->filename, s->filename, sizeof(io->filename));
+    if (s->protocol_whitelist && !(io->protocol_whitelist = av_strdup(s->protocol_whitelist)) ||
+        s->protocol_blacklist && !(io->protocol_blacklist = av_strdup(s->protocol_blacklist))) {
+        avformat_free_context(io);
+        return AVERROR(ENOMEM);
+    }
+    pls->prefetch_io = io;
+
+    return 0;
+}
+
+/*
+ * Reload a live playlist from the prefetch thread. The new segment list is
+ * parsed into a scratch playlist and swapped in under the playlist lock, so
+ * that the demuxer can still look at the old one meanwhile.
+ */
+static int reload_playlist(HLSContext *c, struct playlist *pls)
+{
+    struct playlist *tmp;
+    struct segment **init_sections;
+    int ret;
+
+    tmp = av_mallocz(sizeof(*tmp));
+    if (!tmp)
+        return AVERROR(ENOMEM);
+    tmp->start_seq_no    = pls->start_seq_no;
+    tmp->target_duration = pls->target_duration;
+    tmp->prefetch_io     = pls->prefetch_io;
+
+    ret = parse_playlist(c, pls->url, tmp, NULL);
+    if (ret < 0)
+        goto fail;
+
+    /* the new segments may point to new initialization sections */
+    init_sections = av_realloc_array(pls->init_sections,
+                                     pls->n_init_sections + tmp->n_init_sections,
+                                     sizeof(*init_sections));
+    if (!init_sections) {
+        ret = AVERROR(ENOMEM);
+        goto fail;
+    }
+    memcpy(init_sections + pls->n_init_sections, tmp->init_sections,
+           tmp->n_init_sections * sizeof(*init_sections));
+    pls->init_sections    = init_sections;
+    pls->n_init_sections += tmp->n_init_sections;
+    tmp->n_init_sections  = 0;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    FFSWAP(struct segment **, pls->segments, tmp->segments);
+    FFSWAP(int, pls->n_segments, tmp->n_segments);
+    pls->start_seq_no    = tmp->start_seq_no;
+    pls->target_duration = tmp->target_duration;
+    pls->finished        = tmp->finished;
+    pls->type            = tmp->type;
+    pls->last_load_time  = tmp->last_load_time;
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+fail:
+    free_segment_list(tmp);
+    free_init_section_list(tmp);
+    av_free(tmp);
+    return ret;
+}
+
+/* Download the segment opened in pls->input into the prefetch ring. */
+static int prefetch_segment(struct playlist *pls, struct segment *seg,
+                            int seq_no, int send_init, uint8_t *buf)
+{
+    HLSContext *c = pls->parent->priv_data;
+    struct prefetch_segment *ps;
+    int ret = 0, len;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    ps = &pls->prefetch_segs[(pls->prefetch_head + pls->prefetch_count) % (c->prefetch + 1)];
+    ps->size = ps->pos = ps->init_size = ps->done = 0;
+    ps->seq_no = seq_no;
+    pls->prefetch_count++;
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    if (!pls->init_sec_data_len)
+        send_init = 0;
+    len = send_init ? pls->init_sec_data_len : 0;
+    while (len > 0 || (len = read_from_url(pls, seg, buf, INITIAL_BUFFER_SIZE, READ_NORMAL)) > 0) {
+        const uint8_t *src = send_init ? pls->init_sec_buf : buf;
+        uint8_t *data;
+
+        pthread_mutex_lock(&pls->prefetch_mutex);
+        data = av_fast_realloc(ps->data, &ps->alloc_size, ps->size + len);
+        if (data) {
+            ps->data = data;
+            memcpy(ps->data + ps->size, src, len);
+            ps->size += len;
+            if (send_init)
+                ps->init_size = len;
+            pthread_cond_signal(&pls->prefetch_cond);
+        } else
+            ret = AVERROR(ENOMEM);
+        if (pls->prefetch_abort && !ret)
+            ret = AVERROR_EXIT;
+        pthread_mutex_unlock(&pls->prefetch_mutex);
+
+        if (ret < 0)
+            break;
+        send_init = len = 0;
+    }
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    ps->done = 1;
+    pthread_cond_signal(&pls->prefetch_cond);
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    return ret;
+}
+
+static void *prefetch_thread(void *arg)
+{
+    struct playlist *pls = arg;
+    HLSContext *c = pls->parent->priv_data;
+    int64_t reload_interval;
+    uint8_t *buf;
+    int ret = 0, seq_no, send_init = 0;
+
+    buf = av_malloc(INITIAL_BUFFER_SIZE);
+    if (!buf) {
+        ret = AVERROR(ENOMEM);
+        goto end;
+    }
+    seq_no = pls->prefetch_seq_no;
+
+    for (;;) {
+        struct segment *seg;
+
+        pthread_mutex_lock(&pls->prefetch_mutex);
+        while (!pls->prefetch_abort && pls->prefetch_count > c->prefetch)
+            pthread_cond_wait(&pls->prefetch_cond, &pls->prefetch_mutex);
+        pthread_mutex_unlock(&pls->prefetch_mutex);
+        if (prefetch_aborted(pls))
+            break;
+
+        /* If this is a live stream and the reload interval has elapsed since
+         * the last playlist reload, reload the playlist now. */
+        reload_interval = default_reload_interval(pls);
+
+reload:
+        if (!pls->finished &&
+            av_gettime_relative() - pls->last_load_time >= reload_interval) {
+            if ((ret = reload_playlist(c, pls)) < 0) {
+                av_log(pls->parent, AV_LOG_WARNING, "Failed to reload playlist %d\n",
+                       pls->index);
+                break;
+            }
+            reload_interval = pls->target_duration / 2;
+        }
+        if (seq_no < pls->start_seq_no) {
+            av_log(pls->parent, AV_LOG_WARNING,
+                   "skipping %d segments ahead, expired from playlists\n",
+                   pls->start_seq_no - seq_no);
+            seq_no = pls->start_seq_no;
+        }
+        if (seq_no >= pls->start_seq_no + pls->n_segments) {
+            if (pls->finished) {
+                ret = AVERROR_EOF;
+                break;
+            }
+            while (av_gettime_relative() - pls->last_load_time < reload_interval) {
+                if (prefetch_aborted(pls))
+                    goto end;
+                if (ff_check_interrupt(&pls->prefetch_io->interrupt_callback)) {
+                    ret = AVERROR_EXIT;
+                    goto end;
+                }
+                av_usleep(100*1000);
+            }
+            goto reload;
+        }
+
+        seg = pls->segments[seq_no - pls->start_seq_no];
+
+        /* load/update Media Initialization Section, if any */
+        if (seg->init_section != pls->cur_init_section) {
+            ret = update_init_section(pls, seg);
+            if (ret)
+                break;
+            send_init = !!pls->cur_init_section;
+        }
+
+        ret = open_input(c, pls, seg);
+        if (ret < 0) {
+            if (ff_check_interrupt(&pls->prefetch_io->interrupt_callback)) {
+                ret = AVERROR_EXIT;
+                break;
+            }
+            av_log(pls->parent, AV_LOG_WARNING, "Failed to open segment of playlist %d\n",
+                   pls->index);
+            seq_no++;
+            ret = 0;
+            continue;
+        }
+
+        ret = prefetch_segment(pls, seg, seq_no, send_init, buf);
+        ff_format_io_close(pls->prefetch_io, &pls->input);
+        if (ret < 0)
+            break;
+        send_init = 0;
+        seq_no++;
+    }
+
+end:
+    av_free(buf);
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    pls->prefetch_finished = 1;
+    pls->prefetch_error    = ret < 0 ? ret : AVERROR_EOF;
+    pthread_cond_signal(&pls->prefetch_cond);
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    return NULL;
+}
+
+static int start_prefetch(struct playlist *pls)
+{
+    HLSContext *c = pls->parent->priv_data;
+    int ret;
+
+    if (!pls->prefetch_segs) {
+        pls->prefetch_segs = av_mallocz_array(c->prefetch + 1, sizeof(*pls->prefetch_segs));
+        if (!pls->prefetch_segs)
+            return AVERROR(ENOMEM);
+        pthread_mutex_init(&pls->prefetch_mutex, NULL);
+        pthread_cond_init(&pls->prefetch_cond, NULL);
+    }
+
+    pls->prefetch_head     = 0;
+    pls->prefetch_count    = 0;
+    pls->prefetch_seq_no   = pls->cur_seq_no;
+    pls->prefetch_abort    = 0;
+    pls->prefetch_finished = 0;
+    pls->prefetch_error    = 0;
+    pls->prefetch_reading  = 0;
+
+    if ((ret = alloc_prefetch_io(pls)) < 0)
+        return ret;
+
+    ret = pthread_create(&pls->prefetch_thread, NULL, prefetch_thread, pls);
+    if (ret) {
+        av_log(pls->parent, AV_LOG_ERROR, "pthread_create failed: %s\n",
+               av_err2str(AVERROR(ret)));
+        avformat_free_context(pls->prefetch_io);
+        pls->prefetch_io = NULL;
+        return AVERROR(ret);
+    }
+    pls->prefetch_started = 1;
+
+    return 0;
+}
+#endif
+
+/* Stop downloading, the next read restarts from pls->cur_seq_no. */
+static void stop_prefetch(struct playlist *pls)
+{
+#if HAVE_THREADS
+    if (!pls->prefetch_started)
+        return;
+
+    pthread_mutex_lock(&pls->prefetch_mutex);
+    pls->prefetch_abort = 1;
+    pthread_cond_signal(&pls->prefetch_cond);
+    pthread_mutex_unlock(&pls->prefetch_mutex);
+
+    pthread_join(pls->prefetch_thread, NULL);
+    avformat_free_context(pls->prefetch_io);
+    pls->prefetch_io      = NULL;
+    pls->prefetch_started = 0;
+    pls->prefetch_reading = 0;
+#endif
+}
+
+static void free_prefetch(struct playlist *pls)
+{
+#if HAVE_THREADS
+    HLSContext *c = pls->parent ? pls->parent->priv_data : NULL;
+    int i;
+
+    if (!pls->prefetch_segs)
+        return;
+
+    stop_prefetch(pls);
+    for (i = 0; i <= c->prefetch; i++)
+        av_freep(&pls->prefetch_segs[i].data);
+    av_freep(&pls->prefetch_segs);
+    pthread_mutex_destroy(&pls->prefetch_mutex);
+    pthread_cond_destroy(&pls->prefetch_cond);
+#endif
+}
+
+#if HAVE_THREADS
+static int read_data_prefetch(struct playlist *v, uint8_t *buf, int buf_size)
+{
+    HLSContext *c = v->parent->priv_data;
+    int ret;
+    int just_opened = 0;
+
+    if (!v->prefetch_started && (ret = start_prefetch(v)) < 0)
+        return ret;
+
+restart:
+    if (!v->prefetch_reading) {
+        struct prefetch_segment *ps;
+
+        if (!playlist_needed(v)) {
+            stop_prefetch(v);
+            return AVERROR_EOF;
+        }
+
+        pthread_mutex_lock(&v->prefetch_mutex);
+        while (!v->prefetch_count && !v->prefetch_finished)
+            pthread_cond_wait(&v->prefetch_cond, &v->prefetch_mutex);
+        if (!v->prefetch_count) {
+            ret = v->prefetch_error;
+            pthread_mutex_unlock(&v->prefetch_mutex);
+            return ret;
+        }
+        ps = &v->prefetch_segs[v->prefetch_head];
+        v->cur_seq_no = ps->seq_no;
+        /* spec says audio elementary streams do not have media initialization
+         * sections, so there should be no ID3 timestamps */
+        if (ps->init_size)
+            v->is_id3_timestamped = 0;
+        else
+            just_opened = 1;
+        pthread_mutex_unlock(&v->prefetch_mutex);
+
+        v->prefetch_reading = 1;
+    }
+
+    ret = read_prefetched(v, buf, buf_size, READ_NORMAL);
+    if (ret > 0) {
+        if (just_opened && v->is_id3_timestamped != 0) {
+            /* Intercept ID3 tags here, elementary audio streams are required
+             * to convey timestamps using them in the beginning of each segment. */
+            intercept_id3(v, buf, buf_size, &ret);
+        }
+
+        return ret;
+    }
+
+    pthread_mutex_lock(&v->prefetch_mutex);
+    v->prefetch_head = (v->prefetch_head + 1) % (c->prefetch + 1);
+    v->prefetch_count--;
+    pthread_cond_signal(&v->prefetch_cond);
+    pthread_mutex_unlock(&v->prefetch_mutex);
+    v->prefetch_reading = 0;
+
+    v->cur_seq_no++;
+    c->cur_seq_no = v->cur_seq_no;
+
+    just_opened = 0;
+    goto restart;
+}
+#endif
+
 static int read_data(void *opaque, uint8_t *buf, int buf_size)
 {
     struct playlist *v = opaque;
     HLSContext *c = v->parent->priv_data;
-    int ret, i;
+    int ret;
     int just_opened = 0;
 
 restart:
     if (!v->needed)
         return AVERROR_EOF;
 
+#if HAVE_THREADS
+    if (c->prefetch > 0)
+        return read_data_prefetch(v, buf, buf_size);
+#endif
+
     if (!v->input) {
         int64_t reload_interval;
         struct segment *seg;
 
-        /* Check that the playlist is still needed before opening a new
-         * segment. */
-        if (v->ctx && v->ctx->nb_streams) {
-            v->needed = 0;
-            for (i = 0; i < v->n_main_streams; i++) {
-                if (v->main_streams[i]->discard < AVDISCARD_ALL) {
-                    v->needed = 1;
-                    break;
-                }
-            }
-        }
-        if (!v->needed) {
-            av_log(v->parent, AV_LOG_INFO, "No longer receiving playlist %d\n",
-                v->index);
+        if (!playlist_needed(v))
             return AVERROR_EOF;
-        }
 
         /* If this is a live stream and the reload interval has elapsed since
          * the last playlist reload, reload the playlists now. */
@@ -1331,6 +1874,11 @@ reload:
         if (ret)
             return ret;
 
+        /* spec says audio elementary streams do not have media initialization
+         * sections, so there should be no ID3 timestamps */
+        if (v->cur_init_section)
+            v->is_id3_timestamped = 0;
+
         ret = open_input(c, v, seg);
         if (ret < 0) {
             if (ff_check_interrupt(c->interrupt_callback))
@@ -1622,6 +2170,10 @@ static int hls_close(AVFormatContext *s)
     free_rendition_list(c);
 
     av_dict_free(&c->avio_opts);
+#if HAVE_THREADS
+    if (c->prefetch > 0)
+        pthread_mutex_destroy(&c->cookies_mutex);
+#endif
 
     return 0;
 }
@@ -1641,6 +2193,11 @@ static int hls_read_header(AVFormatContext *s)
     c->first_timestamp = AV_NOPTS_VALUE;
     c->cur_timestamp = AV_NOPTS_VALUE;
 
+#if HAVE_THREADS
+    if (c->prefetch > 0)
+        pthread_mutex_init(&c->cookies_mutex, NULL);
+#endif
+
     if (u) {
         // get the previous user agent & set back to null if string size is zero
         update_options(&c->user_agent, "user_agent", u);
@@ -1732,6 +2289,7 @@ static int hls_read_header(AVFormatContext *s)
     for (i = 0; i < c->n_playlists; i++) {
         struct playlist *pls = c->playlists[i];
         AVInputFormat *in_fmt = NULL;
+        char *first_url;
 
         if (!(pls->ctx = avformat_alloc_context())) {
             ret = AVERROR(ENOMEM);
@@ -1767,14 +2325,23 @@ static int hls_read_header(AVFormatContext *s)
         ffio_init_context(&pls->pb, pls->read_buffer, INITIAL_BUFFER_SIZE, 0, pls,
                           read_data, NULL, NULL);
         pls->pb.seekable = 0;
-        ret = av_probe_input_buffer(&pls->pb, &in_fmt, pls->segments[0]->url,
+        /* the segment list may be reloaded by the prefetch thread meanwhile */
+        first_url = av_strdup(pls->segments[0]->url);
+        if (!first_url) {
+            ret = AVERROR(ENOMEM);
+            avformat_free_context(pls->ctx);
+            pls->ctx = NULL;
+            goto fail;
+        }
+        ret = av_probe_input_buffer(&pls->pb, &in_fmt, first_url,
                                     NULL, 0, 0);
         if (ret < 0) {
             /* Free the ctx - it isn't initialized properly at this point,
              * so avformat_close_input shouldn't be called. If
              * avformat_open_input fails below, it frees and zeros the
              * context, so it doesn't need any special treatment like this. */
-            av_log(s, AV_LOG_ERROR, "Error when loading first segment '%s'\n", pls->segments[0]->url);
+            av_log(s, AV_LOG_ERROR, "Error when loading first segment '%s'\n", first_url);
+            av_free(first_url);
             avformat_free_context(pls->ctx);
             pls->ctx = NULL;
             goto fail;
@@ -1783,10 +2350,13 @@ static int hls_read_header(AVFormatContext *s)
         pls->ctx->io_open  = nested_io_open;
         pls->ctx->flags   |= s->flags & ~AVFMT_FLAG_CUSTOM_IO;
 
-        if ((ret = ff_copy_whiteblacklists(pls->ctx, s)) < 0)
+        if ((ret = ff_copy_whiteblacklists(pls->ctx, s)) < 0) {
+            av_free(first_url);
             goto fail;
+        }
 
-        ret = avformat_open_input(&pls->ctx, pls->segments[0]->url, in_fmt, NULL);
+        ret = avformat_open_input(&pls->ctx, first_url, in_fmt, NULL);
+        av_free(first_url);
         if (ret < 0)
             goto fail;
 
@@ -1862,6 +2432,7 @@ static int recheck_discard_flags(AVFormatContext *s, int first)
             }
             av_log(s, AV_LOG_INFO, "Now receiving playlist %d, segment %d\n", i, pls->cur_seq_no);
         } else if (first && !pls->cur_needed && pls->needed) {
+            stop_prefetch(pls);
             if (pls->input)
                 ff_format_io_close(pls->parent, &pls->input);
             pls->needed = 0;
@@ -2050,13 +2621,16 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
 {
     HLSContext *c = s->priv_data;
     struct playlist *seek_pls = NULL;
-    int i, seq_no;
+    struct playlist *main_pls = c->variants[0]->playlists[0];
+    int i, seq_no, seekable, found;
     int j;
     int stream_subdemuxer_index;
     int64_t first_timestamp, seek_timestamp, duration;
 
-    if ((flags & AVSEEK_FLAG_BYTE) ||
-        !(c->variants[0]->playlists[0]->finished || c->variants[0]->playlists[0]->type == PLS_TYPE_EVENT))
+    lock_playlist(main_pls);
+    seekable = main_pls->finished || main_pls->type == PLS_TYPE_EVENT;
+    unlock_playlist(main_pls);
+    if ((flags & AVSEEK_FLAG_BYTE) || !seekable)
         return AVERROR(ENOSYS);
 
     first_timestamp = c->first_timestamp == AV_NOPTS_VALUE ?
@@ -2086,8 +2660,17 @@ static int hls_read_seek(AVFormatContext *s, int stream_index,
     }
     /* check if the timestamp is valid for the playlist with the
      * specified stream index */
-    if (!seek_pls || !find_timestamp_in_playlist(c, seek_pls, seek_timestamp, &seq_no))
+    if (!seek_pls)
         return AVERROR(EIO);
+    lock_playlist(seek_pls);
+    found = find_timestamp_in_playlist(c, seek_pls, seek_timestamp, &seq_no);
+    unlock_playlist(seek_pls);
+    if (!found)
+        return AVERROR(EIO);
+
+    /* the prefetch threads restart from the new position on the next read */
+    for (i = 0; i < c->n_playlists; i++)
+        stop_prefetch(c->playlists[i]);
 
     /* set segment now so we do not need to search again below */
     seek_pls->cur_seq_no = seq_no;
@@ -2150,6 +2733,8 @@ static const AVOption hls_options[] = {
         OFFSET(allowed_extensions), AV_OPT_TYPE_STRING,
         {.str = "3gp,aac,avi,flac,mkv,m3u8,m4a,m4s,m4v,mpg,mov,mp2,mp3,mp4,mpeg,mpegts,ogg,ogv,oga,ts,vob,wav"},
         INT_MIN, INT_MAX, FLAGS},
+    {"prefetch", "number of segments to download ahead of the one being read, per playlist",
+        OFFSET(prefetch), AV_OPT_TYPE_INT, {.i64 = 0}, 0, 64, FLAGS},
     {NULL}
 };
 
@@ -42,6 +42,7 @@
 #include "libavutil/log.h"
 #include "libavutil/time_internal.h"
 
+#include "asyncwriter.h"
 #include "avformat.h"
 #include "avio_internal.h"
 #include "internal.h"
@@ -164,6 +165,14 @@ typedef struct HLSContext {
 
     double initial_prog_date_time;
     char current_segment_final_filename_fmt[1024]; // when renaming segments
+
+    int streaming;         ///< push segment data out while the segment is written
+    int64_t frag_duration;
+    int64_t chunk_start_pts;
+
+    int async_queue_size;  ///< max pending output operations, 0 for synchronous output
+    int async_queue_depth; ///< exported number of pending output operations
+    AsyncWriter *writer;
 } HLSContext;
 
 static int get_int_from_double(double val)
@@ -256,6 +265,36 @@ fail:
     return -1;
 }
 
+static int hlsenc_io_open(AVFormatContext *s, AVIOContext **pb, const char *filename,
+                          AVDictionary **options)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->writer)
+        return ff_async_writer_open(hls->writer, pb, filename, options);
+    return s->io_open(s, pb, filename, AVIO_FLAG_WRITE, options);
+}
+
+static void hlsenc_io_close(AVFormatContext *s, AVIOContext **pb)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->writer)
+        ff_async_writer_close(hls->writer, pb);
+    else
+        ff_format_io_close(s, pb);
+}
+
+static void hlsenc_rename(AVFormatContext *s, const char *oldpath, const char *newpath)
+{
+    HLSContext *hls = s->priv_data;
+
+    if (hls->writer)
+        ff_async_writer_rename(hls->writer, oldpath, newpath);
+    else
+        ff_rename(oldpath, newpath, s);
+}
+
 static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls) {
 
     HLSSegment *segment, *previous_segment = NULL;
@@ -318,9 +357,12 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls) {
         proto = avio_find_protocol_name(s->filename);
         if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
             av_dict_set(&options, "method", "DELETE", 0);
-            if ((ret = hls->avf->io_open(hls->avf, &out, path, AVIO_FLAG_WRITE, &options)) < 0)
+            if ((ret = hlsenc_io_open(s, &out, path, &options)) < 0)
+                goto fail;
+            hlsenc_io_close(s, &out);
+        } else if (hls->writer) {
+            if ((ret = ff_async_writer_delete(hls->writer, path)) < 0)
                 goto fail;
-            ff_format_io_close(hls->avf, &out);
         } else if (unlink(path) < 0) {
             av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                                      path, strerror(errno));
@@ -339,11 +381,17 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls) {
 
             if (hls->method || (proto && !av_strcasecmp(proto, "http"))) {
                 av_dict_set(&options, "method", "DELETE", 0);
-                if ((ret = hls->avf->io_open(hls->avf, &out, sub_path, AVIO_FLAG_WRITE, &options)) < 0) {
+                if ((ret = hlsenc_io_open(s, &out, sub_path, &options)) < 0) {
+                    av_free(sub_path);
+                    goto fail;
+                }
+                hlsenc_io_close(s, &out);
+            } else if (hls->writer) {
+                ret = ff_async_writer_delete(hls->writer, sub_path);
+                if (ret < 0) {
                     av_free(sub_path);
                     goto fail;
                 }
-                ff_format_io_close(hls->avf, &out);
             } else if (unlink(sub_path) < 0) {
                 av_log(hls, AV_LOG_ERROR, "failed to delete old segment %s: %s\n",
                                          sub_path, strerror(errno));
@@ -357,6 +405,7 @@ static int hls_delete_old_segments(AVFormatContext *s, HLSContext *hls) {
     }
 
 fail:
+    av_dict_free(&options);
     av_free(path);
     av_free(dirname);
 
@@ -436,11 +485,11 @@ static int do_encrypt(AVFormatContext *s)
         }
 
         ff_data_to_hex(hls->key_string, key, sizeof(key), 0);
-        if ((ret = s->io_open(s, &pb, hls->key_file, AVIO_FLAG_WRITE, NULL)) < 0)
+        if ((ret = hlsenc_io_open(s, &pb, hls->key_file, NULL)) < 0)
             return ret;
         avio_seek(pb, 0, SEEK_CUR);
         avio_write(pb, key, KEYSIZE);
-        avio_close(pb);
+        hlsenc_io_close(s, &pb);
     }
     return 0;
 }
@@ -656,10 +705,10 @@ static int sls_flag_check_duration_size(HLSContext *hls)
     return ret;
 }
 
-static void sls_flag_file_rename(HLSContext *hls, char *old_filename) {
+static void sls_flag_file_rename(AVFormatContext *s, HLSContext *hls, char *old_filename) {
     if ((hls->flags & (HLS_SECOND_LEVEL_SEGMENT_SIZE | HLS_SECOND_LEVEL_SEGMENT_DURATION)) &&
         strlen(hls->current_segment_final_filename_fmt)) {
-        ff_rename(old_filename, hls->avf->filename, hls);
+        hlsenc_rename(s, old_filename, hls->avf->filename);
     }
 }
 
@@ -931,7 +980,7 @@ static void hls_rename_temp_file(AVFormatContext *s, AVFormatContext *oc)
 
     av_strlcpy(final_filename, oc->filename, len);
     final_filename[len-4] = '\0';
-    ff_rename(oc->filename, final_filename, s);
+    hlsenc_rename(s, oc->filename, final_filename);
     oc->filename[len-4] = '\0';
 }
 
@@ -965,7 +1014,7 @@ static int hls_window(AVFormatContext *s, int last)
 
     set_http_options(s, &options, hls);
     snprintf(temp_filename, sizeof(temp_filename), use_rename ? "%s.tmp" : "%s", s->filename);
-    if ((ret = s->io_open(s, &out, temp_filename, AVIO_FLAG_WRITE, &options)) < 0)
+    if ((ret = hlsenc_io_open(s, &out, temp_filename, &options)) < 0)
         goto fail;
 
     for (en = hls->segments; en; en = en->next) {
@@ -1036,11 +1085,20 @@ static int hls_window(AVFormatContext *s, int last)
         avio_printf(out, "%s\n", en->filename);
     }
 
+    /* Announce the segment being written, clients can start fetching it
+     * before it is complete. */
+    if (!last && hls->streaming && !byterange_mode && hls->avf && hls->avf->pb &&
+        !*hls->current_segment_final_filename_fmt) {
+        const char *filename = hls->use_localtime_mkdir ? hls->avf->filename :
+                                                          av_basename(hls->avf->filename);
+        avio_printf(out, "#EXT-X-PREFETCH:%s%s\n", hls->baseurl ? hls->baseurl : "", filename);
+    }
+
     if (last && (hls->flags & HLS_OMIT_ENDLIST)==0)
         avio_printf(out, "#EXT-X-ENDLIST\n");
 
     if( hls->vtt_m3u8_name ) {
-        if ((ret = s->io_open(s, &sub_out, hls->vtt_m3u8_name, AVIO_FLAG_WRITE, &options)) < 0)
+        if ((ret = hlsenc_io_open(s, &sub_out, hls->vtt_m3u8_name, &options)) < 0)
             goto fail;
         write_m3u8_head_block(hls, sub_out, version, target_duration, sequence);
 
@@ -1061,10 +1119,10 @@ static int hls_window(AVFormatContext *s, int last)
 
 fail:
     av_dict_free(&options);
-    ff_format_io_close(s, &out);
-    ff_format_io_close(s, &sub_out);
+    hlsenc_io_close(s, &out);
+    hlsenc_io_close(s, &sub_out);
     if (ret >= 0 && use_rename)
-        ff_rename(temp_filename, s->filename, s);
+        hlsenc_rename(s, temp_filename, s->filename);
     return ret;
 }
 
@@ -1178,17 +1236,17 @@ static int hls_start(AVFormatContext *s)
             err = AVERROR(ENOMEM);
             goto fail;
         }
-        err = s->io_open(s, &oc->pb, filename, AVIO_FLAG_WRITE, &options);
+        err = hlsenc_io_open(s, &oc->pb, filename, &options);
         av_free(filename);
         av_dict_free(&options);
         if (err < 0)
             return err;
     } else
-        if ((err = s->io_open(s, &oc->pb, oc->filename, AVIO_FLAG_WRITE, &options)) < 0)
+        if ((err = hlsenc_io_open(s, &oc->pb, oc->filename, &options)) < 0)
             goto fail;
     if (c->vtt_basename) {
         set_http_options(s, &options, c);
-        if ((err = s->io_open(s, &vtt_oc->pb, vtt_oc->filename, AVIO_FLAG_WRITE, &options)) < 0)
+        if ((err = hlsenc_io_open(s, &vtt_oc->pb, vtt_oc->filename, &options)) < 0)
             goto fail;
     }
     av_dict_free(&options);
@@ -1260,8 +1318,14 @@ static int hls_write_header(AVFormatContext *s)
     hls->sequence       = hls->start_sequence;
     hls->recording_time = (hls->init_time ? hls->init_time : hls->time) * AV_TIME_BASE;
     hls->start_pts      = AV_NOPTS_VALUE;
+    hls->chunk_start_pts = AV_NOPTS_VALUE;
     hls->current_segment_final_filename_fmt[0] = '\0';
 
+    if (hls->streaming && (hls->flags & HLS_TEMP_FILE)) {
+        av_log(s, AV_LOG_WARNING, "temp_file is not compatible with streaming, disabling it\n");
+        hls->flags &= ~HLS_TEMP_FILE;
+    }
+
     if (hls->flags & HLS_PROGRAM_DATE_TIME) {
         time_t now0;
         time(&now0);
@@ -1389,6 +1453,16 @@ static int hls_write_header(AVFormatContext *s)
         }
     }
 
+    if (hls->async_queue_size > 0) {
+        ret = ff_async_writer_alloc(&hls->writer, s, hls->async_queue_size);
+        if (ret == AVERROR(ENOSYS)) {
+            av_log(s, AV_LOG_WARNING, "Asynchronous output requires threads, "
+                   "writing synchronously\n");
+        } else if (ret < 0) {
+            goto fail;
+        }
+    }
+
     if ((ret = hls_start(s)) < 0)
         goto fail;
 
@@ -1510,9 +1584,9 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         hls->size = new_start_pos - hls->start_pos;
 
         if (!byterange_mode) {
-            ff_format_io_close(s, &oc->pb);
+            hlsenc_io_close(s, &oc->pb);
             if (hls->vtt_avf) {
-                ff_format_io_close(s, &hls->vtt_avf->pb);
+                hlsenc_io_close(s, &hls->vtt_avf->pb);
             }
         }
         if ((hls->flags & HLS_TEMP_FILE) && oc->filename[0]) {
@@ -1537,7 +1611,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
         } else if (hls->max_seg_size > 0) {
             if (hls->start_pos >= hls->max_seg_size) {
                 hls->sequence++;
-                sls_flag_file_rename(hls, old_filename);
+                sls_flag_file_rename(s, hls, old_filename);
                 ret = hls_start(s);
                 hls->start_pos = 0;
                 /* When split segment by byte, the duration is short than hls_time,
@@ -1546,7 +1620,7 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
             }
             hls->number++;
         } else {
-            sls_flag_file_rename(hls, old_filename);
+            sls_flag_file_rename(s, hls, old_filename);
             ret = hls_start(s);
         }
         av_free(old_filename);
@@ -1562,6 +1636,21 @@ static int hls_write_packet(AVFormatContext *s, AVPacket *pkt)
 
     ret = ff_write_chained(oc, stream_index, pkt, s, 0);
 
+    if (ret >= 0 && hls->streaming && pkt->pts != AV_NOPTS_VALUE) {
+        int64_t pts = av_rescale_q(pkt->pts, st->time_base, AV_TIME_BASE_Q);
+
+        if (hls->chunk_start_pts == AV_NOPTS_VALUE)
+            hls->chunk_start_pts = pts;
+        if (pts - hls->chunk_start_pts >= hls->frag_duration) {
+            av_write_frame(oc, NULL);
+            avio_flush(oc->pb);
+            hls->chunk_start_pts = AV_NOPTS_VALUE;
+        }
+    }
+
+    if (hls->writer)
+        hls->async_queue_depth = ff_async_writer_queue_depth(hls->writer);
+
     return ret;
 }
 
@@ -1580,7 +1669,7 @@ static int hls_write_trailer(struct AVFormatContext *s)
     av_write_trailer(oc);
     if (oc->pb) {
         hls->size = avio_tell(hls->avf->pb) - hls->start_pos;
-        ff_format_io_close(s, &oc->pb);
+        hlsenc_io_close(s, &oc->pb);
 
         if ((hls->flags & HLS_TEMP_FILE) && oc->filename[0]) {
             hls_rename_temp_file(s, oc);
@@ -1590,13 +1679,13 @@ static int hls_write_trailer(struct AVFormatContext *s)
         hls_append_segment(s, hls, hls->duration + hls->dpp, hls->start_pos, hls->size);
     }
 
-    sls_flag_file_rename(hls, old_filename);
+    sls_flag_file_rename(s, hls, old_filename);
 
     if (vtt_oc) {
         if (vtt_oc->pb)
             av_write_trailer(vtt_oc);
         hls->size = avio_tell(hls->vtt_avf->pb) - hls->start_pos;
-        ff_format_io_close(s, &vtt_oc->pb);
+        hlsenc_io_close(s, &vtt_oc->pb);
     }
     av_freep(&hls->basename);
     av_freep(&hls->key_basename);
@@ -1614,7 +1703,14 @@ static int hls_write_trailer(struct AVFormatContext *s)
     hls_free_segments(hls->segments);
     hls_free_segments(hls->old_segments);
     av_free(old_filename);
-    return 0;
+    return ff_async_writer_free(&hls->writer);
+}
+
+static void hls_deinit(AVFormatContext *s)
+{
+    HLSContext *hls = s->priv_data;
+
+    ff_async_writer_free(&hls->writer);
 }
 
 #define OFFSET(x) offsetof(HLSContext, x)
@@ -1662,6 +1758,10 @@ static const AVOption options[] = {
     {"generic", "start_number value (default)", 0, AV_OPT_TYPE_CONST, {.i64 = HLS_START_SEQUENCE_AS_START_NUMBER }, INT_MIN, INT_MAX, E, "start_sequence_source_type" },
     {"epoch", "seconds since epoch", 0, AV_OPT_TYPE_CONST, {.i64 = HLS_START_SEQUENCE_AS_SECONDS_SINCE_EPOCH }, INT_MIN, INT_MAX, E, "start_sequence_source_type" },
     {"datetime", "current datetime as YYYYMMDDhhmmss", 0, AV_OPT_TYPE_CONST, {.i64 = HLS_START_SEQUENCE_AS_FORMATTED_DATETIME }, INT_MIN, INT_MAX, E, "start_sequence_source_type" },
+    {"streaming", "write out segment data while the segment is produced, for low latency", OFFSET(streaming), AV_OPT_TYPE_BOOL, {.i64 = 0}, 0, 1, E},
+    {"frag_duration", "minimum duration of the chunks written out in streaming mode (in microseconds), 0 for one chunk per packet", OFFSET(frag_duration), AV_OPT_TYPE_INT64, {.i64 = 0}, 0, INT64_MAX, E},
+    {"async_queue_size", "write segments and playlists from a separate thread, with at most this many pending operations", OFFSET(async_queue_size), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX / 64, E},
+    {"async_queue_depth", "number of pending output operations", OFFSET(async_queue_depth), AV_OPT_TYPE_INT, {.i64 = 0}, 0, INT_MAX, E | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY},
     { NULL },
 };
 
@@ -1685,5 +1785,6 @@ AVOutputFormat ff_hls_muxer = {
     .write_header   = hls_write_header,
     .write_packet   = hls_write_packet,
     .write_trailer  = hls_write_trailer,
+    .deinit         = hls_deinit,
     .priv_class     = &hls_class,
 };
@@ -28,6 +28,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/avstring.h"
 #include "libavutil/opt.h"
+#include "libavutil/thread.h"
 #include "libavutil/time.h"
 #include "libavutil/parseutils.h"
 
@@ -50,6 +51,7 @@
 #define HTTP_SINGLE   1
 #define HTTP_MUTLI    2
 #define MAX_EXPIRY    19
+#define HTTP_POOL_SIZE 32
 #define WHITESPACES " \n\t\r"
 typedef enum {
     LOWER_PROTO,
@@ -58,6 +60,22 @@ typedef enum {
     FINISH
 }HandshakeState;
 
+/* Lower protocol connection opened by the HTTP protocol. It is handed
+ * around between HTTP contexts through the connection pool, so the lower
+ * protocols are given an interrupt callback forwarding to the callback of
+ * the context currently using it. */
+typedef struct HTTPConnection {
+    URLContext *hd;
+    AVIOInterruptCB int_cb;
+    char *key;              ///< lower protocol URL and options, NULL if not poolable
+    int64_t expiry;         ///< when an idle pooled connection gets closed
+} HTTPConnection;
+
+/* Idle persistent connections, shared by all HTTP contexts. */
+static HTTPConnection *http_pool[HTTP_POOL_SIZE];
+static AVMutex http_pool_mutex;
+static AVOnce http_pool_once = AV_ONCE_INIT;
+
 typedef struct HTTPContext {
     const AVClass *class;
     URLContext *hd;
@@ -89,6 +107,12 @@ typedef struct HTTPContext {
     int end_header;
     /* A flag which indicates if we use persistent connections. */
     int multiple_requests;
+    /* Set when the last chunk of a chunked reply has been read. */
+    int chunked_eof;
+    /* Idle connections are kept in the shared connection pool. */
+    int keepalive;
+    int keepalive_timeout;
+    int keepalive_max_connections;
     uint8_t *post_data;
     int post_datalen;
     int is_akamai;
@@ -141,6 +165,9 @@ static const AVOption options[] = {
     { "user-agent", "override User-Agent header", OFFSET(user_agent_deprecated), AV_OPT_TYPE_STRING, { .str = DEFAULT_USER_AGENT }, 0, 0, D },
 #endif
     { "multiple_requests", "use persistent connections", OFFSET(multiple_requests), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, D | E },
+    { "keepalive", "reuse idle connections to the same server from a shared pool", OFFSET(keepalive), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, D | E },
+    { "keepalive_timeout", "seconds an idle connection is kept in the pool", OFFSET(keepalive_timeout), AV_OPT_TYPE_INT, { .i64 = 15 }, 0, INT_MAX / 1000000, D | E },
+    { "keepalive_max_connections", "maximum number of idle connections kept per server", OFFSET(keepalive_max_connections), AV_OPT_TYPE_INT, { .i64 = 4 }, 0, HTTP_POOL_SIZE, D | E },
     { "post_data", "set custom HTTP post data", OFFSET(post_data), AV_OPT_TYPE_BINARY, .flags = D | E },
     { "mime_type", "export the MIME type", OFFSET(mime_type), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
     { "cookies", "set cookies to be sent in applicable future requests, use newline delimited Set-Cookie HTTP field value syntax", OFFSET(cookies), AV_OPT_TYPE_STRING, { .str = NULL }, 0, 0, D },
@@ -181,6 +208,204 @@ void ff_http_init_auth_state(URLContext *dest, const URLContext *src)
            sizeof(HTTPAuthState));
 }
 
+static void http_pool_init(void)
+{
+    ff_mutex_init(&http_pool_mutex, NULL);
+}
+
+static void http_pool_lock(void)
+{
+    ff_thread_once(&http_pool_once, http_pool_init);
+    ff_mutex_lock(&http_pool_mutex);
+}
+
+static void http_pool_unlock(void)
+{
+    ff_mutex_unlock(&http_pool_mutex);
+}
+
+static int http_conn_interrupt_cb(void *opaque)
+{
+    HTTPConnection *conn = opaque;
+    return ff_check_interrupt(&conn->int_cb);
+}
+
+static HTTPConnection *http_conn(URLContext *hd)
+{
+    if (hd && hd->interrupt_callback.callback == http_conn_interrupt_cb)
+        return hd->interrupt_callback.opaque;
+    return NULL;
+}
+
+static void http_conn_close(URLContext **hd)
+{
+    HTTPConnection *conn = http_conn(*hd);
+
+    ffurl_closep(hd);
+    if (conn) {
+        av_free(conn->key);
+        av_free(conn);
+    }
+}
+
+/* An idle connection has nothing to read, unless the server closed it. */
+static int http_conn_alive(URLContext *hd)
+{
+    struct pollfd p = { ffurl_get_file_handle(hd), POLLIN, 0 };
+
+    if (p.fd < 0)
+        return 1;
+    return !poll(&p, 1, 0);
+}
+
+static char *http_pool_key(URLContext *h, const char *lower_url,
+                           AVDictionary *options)
+{
+    char *opts = NULL, *key;
+
+    if (av_dict_get_string(options, &opts, '=', ',') < 0)
+        return NULL;
+    key = av_asprintf("%s|%s|%s|%s", lower_url,
+                      h->protocol_whitelist ? h->protocol_whitelist : "",
+                      h->protocol_blacklist ? h->protocol_blacklist : "",
+                      opts);
+    av_free(opts);
+    return key;
+}
+
+/* Take an idle connection matching key out of the pool, closing the
+ * expired ones on the way. */
+static URLContext *http_pool_get(URLContext *h, const char *key)
+{
+    HTTPConnection *stale[HTTP_POOL_SIZE];
+    URLContext *hd = NULL;
+    int64_t now = av_gettime_relative();
+    int i, nb_stale = 0;
+
+    http_pool_lock();
+    for (i = 0; i < HTTP_POOL_SIZE; i++) {
+        HTTPConnection *conn = http_pool[i];
+        if (!conn)
+            continue;
+        if (conn->expiry < now || !http_conn_alive(conn->hd)) {
+            stale[nb_stale++] = conn;
+            http_pool[i] = NULL;
+        } else if (!hd && !strcmp(conn->key, key)) {
+            hd = conn->hd;
+            conn->hd     = NULL;
+            conn->int_cb = h->interrupt_callback;
+            http_pool[i] = NULL;
+        }
+    }
+    http_pool_unlock();
+
+    for (i = 0; i < nb_stale; i++)
+        http_conn_close(&stale[i]->hd);
+
+    return hd;
+}
+
+void ff_http_pool_close(void)
+{
+    HTTPConnection *idle[HTTP_POOL_SIZE];
+    int i, nb_idle = 0;
+
+    http_pool_lock();
+    for (i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (http_pool[i])
+            idle[nb_idle++] = http_pool[i];
+        http_pool[i] = NULL;
+    }
+    http_pool_unlock();
+
+    for (i = 0; i < nb_idle; i++)
+        http_conn_close(&idle[i]->hd);
+}
+
+/* Put an idle connection into the pool, return 0 if there is no room. */
+static int http_pool_put(HTTPContext *s, URLContext *hd)
+{
+    HTTPConnection *conn = http_conn(hd);
+    int i, free_slot = -1, nb_same = 0;
+
+    if (!conn || !conn->key || !s->keepalive_timeout)
+        return 0;
+
+    http_pool_lock();
+    for (i = 0; i < HTTP_POOL_SIZE; i++) {
+        if (!http_pool[i])
+            free_slot = i;
+        else if (!strcmp(http_pool[i]->key, conn->key))
+            nb_same++;
+    }
+    if (free_slot >= 0 && nb_same < s->keepalive_max_connections) {
+        conn->hd     = hd;
+        conn->int_cb = (AVIOInterruptCB){ NULL, NULL };
+        conn->expiry = av_gettime_relative() + s->keepalive_timeout * 1000000LL;
+        http_pool[free_slot] = conn;
+    }
+    http_pool_unlock();
+
+    return free_slot >= 0 && nb_same < s->keepalive_max_connections;
+}
+
+/* Open the connection to the server or the proxy, return 1 if an idle
+ * connection from the pool was reused. */
+static int http_open_hd(URLContext *h, const char *lower_url,
+                        AVDictionary **options, int use_pool)
+{
+    HTTPContext *s = h->priv_data;
+    HTTPConnection *conn;
+    AVIOInterruptCB int_cb;
+    int err;
+
+    if (!(conn = av_mallocz(sizeof(*conn))))
+        return AVERROR(ENOMEM);
+
+    if (s->keepalive) {
+        if (!(conn->key = http_pool_key(h, lower_url, *options))) {
+            av_free(conn);
+            return AVERROR(ENOMEM);
+        }
+        if (use_pool && (s->hd = http_pool_get(h, conn->key))) {
+            av_log(h, AV_LOG_DEBUG, "Reusing connection to %s\n", lower_url);
+            av_free(conn->key);
+            av_free(conn);
+            return 1;
+        }
+    }
+
+    conn->int_cb    = h->interrupt_callback;
+    int_cb.callback = http_conn_interrupt_cb;
+    int_cb.opaque   = conn;
+    err = ffurl_open_whitelist(&s->hd, lower_url, AVIO_FLAG_READ_WRITE,
+                               &int_cb, options,
+                               h->protocol_whitelist, h->protocol_blacklist, h);
+    if (err < 0) {
+        av_free(conn->key);
+        av_free(conn);
+    }
+    return err < 0 ? err : 0;
+}
+
+/* Return 1 if the request may be sent again without changing its effect,
+ * see RFC 7231 4.2.2. */
+static int http_method_is_idempotent(URLContext *h)
+{
+    static const char *const methods[] = {
+        "GET", "HEAD", "PUT", "DELETE", "OPTIONS", "TRACE",
+    };
+    HTTPContext *s = h->priv_data;
+    int i;
+
+    if (!s->method)
+        return !(h->flags & AVIO_FLAG_WRITE) && !s->post_data;
+    for (i = 0; i < FF_ARRAY_ELEMS(methods); i++)
+        if (!av_strcasecmp(s->method, methods[i]))
+            return 1;
+    return 0;
+}
+
 static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
 {
     const char *path, *proxy_path, *lower_proto = "tcp", *local_path;
@@ -188,8 +413,9 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     char auth[1024], proxyauth[1024] = "";
     char path1[MAX_URL_SIZE];
     char buf[1024], urlbuf[MAX_URL_SIZE];
-    int port, use_proxy, err, location_changed = 0;
+    int port, use_proxy, err, location_changed = 0, reused = 0;
     HTTPContext *s = h->priv_data;
+    uint64_t off = s->off;
 
     av_url_split(proto, sizeof(proto), auth, sizeof(auth),
                  hostname, sizeof(hostname), &port,
@@ -227,15 +453,29 @@ static int http_open_cnx_internal(URLContext *h, AVDictionary **options)
     ff_url_join(buf, sizeof(buf), lower_proto, NULL, hostname, port, NULL);
 
     if (!s->hd) {
-        err = ffurl_open_whitelist(&s->hd, buf, AVIO_FLAG_READ_WRITE,
-                                   &h->interrupt_callback, options,
-                                   h->protocol_whitelist, h->protocol_blacklist, h);
+        err = http_open_hd(h, buf, options, 1);
         if (err < 0)
             return err;
+        reused = err;
     }
 
+    /* empty the input buffer to tell whether a failed request got a reply */
+    s->buf_ptr = s->buf_end = s->buffer;
     err = http_connect(h, path, local_path, hoststr,
                        auth, proxyauth, &location_changed);
+    if (err < 0 && reused && s->buf_end == s->buffer &&
+        http_method_is_idempotent(h)) {
+        /* the server may have dropped the idle connection meanwhile, the
+         * request is only sent again if it cannot have been applied twice */
+        av_log(h, AV_LOG_DEBUG, "Request on reused connection failed, retrying\n");
+        http_conn_close(&s->hd);
+        s->off = off;
+        location_changed = 0;
+        if ((err = http_open_hd(h, buf, options, 0)) < 0)
+            return err;
+        err = http_connect(h, path, local_path, hoststr,
+                           auth, proxyauth, &location_changed);
+    }
     if (err < 0)
         return err;
 
@@ -262,7 +502,7 @@ redo:
     if (s->http_code == 401) {
         if ((cur_auth_type == HTTP_AUTH_NONE || s->auth_state.stale) &&
             s->auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_closep(&s->hd);
+            http_conn_close(&s->hd);
             goto redo;
         } else
             goto fail;
@@ -270,7 +510,7 @@ redo:
     if (s->http_code == 407) {
         if ((cur_proxy_auth_type == HTTP_AUTH_NONE || s->proxy_auth_state.stale) &&
             s->proxy_auth_state.auth_type != HTTP_AUTH_NONE && attempts < 4) {
-            ffurl_closep(&s->hd);
+            http_conn_close(&s->hd);
             goto redo;
         } else
             goto fail;
@@ -279,7 +519,7 @@ redo:
          s->http_code == 303 || s->http_code == 307) &&
         location_changed == 1) {
         /* url moved, get next */
-        ffurl_closep(&s->hd);
+        http_conn_close(&s->hd);
         if (redirects++ >= MAX_REDIRECTS)
             return AVERROR(EIO);
         /* Restart the authentication process with the new target, which
@@ -293,7 +533,7 @@ redo:
 
 fail:
     if (s->hd)
-        ffurl_closep(&s->hd);
+        http_conn_close(&s->hd);
     if (location_changed < 0)
         return location_changed;
     return ff_http_averror(s->http_code, AVERROR(EIO));
@@ -1072,7 +1312,8 @@ static int http_read_header(URLContext *h, int *new_location)
     char line[MAX_URL_SIZE];
     int err = 0;
 
-    s->chunksize = UINT64_MAX;
+    s->chunksize   = UINT64_MAX;
+    s->chunked_eof = 0;
 
     for (;;) {
         if ((err = http_get_line(s, line, sizeof(line))) < 0)
@@ -1173,7 +1414,7 @@ static int http_connect(URLContext *h, const char *path, const char *local_path,
                            "Expect: 100-continue\r\n");
 
     if (!has_header(s->headers, "\r\nConnection: ")) {
-        if (s->multiple_requests)
+        if (s->multiple_requests || s->keepalive)
             len += av_strlcpy(headers + len, "Connection: keep-alive\r\n",
                               sizeof(headers) - len);
         else
@@ -1278,6 +1519,8 @@ static int http_buf_read(URLContext *h, uint8_t *buf, int size)
     int len;
 
     if (s->chunksize != UINT64_MAX) {
+        if (s->chunked_eof)
+            return 0;
         if (!s->chunksize) {
             char line[32];
             int err;
@@ -1293,9 +1536,17 @@ static int http_buf_read(URLContext *h, uint8_t *buf, int size)
                    "Chunked encoding data size: %"PRIu64"'\n",
                     s->chunksize);
 
-            if (!s->chunksize)
+            if (!s->chunksize) {
+                /* skip the trailer, the connection may be reused */
+                do {
+                    if (http_get_line(s, line, sizeof(line)) < 0) {
+                        s->willclose = 1;
+                        break;
+                    }
+                } while (*line);
+                s->chunked_eof = 1;
                 return 0;
-            else if (s->chunksize == UINT64_MAX) {
+            } else if (s->chunksize == UINT64_MAX) {
                 av_log(h, AV_LOG_ERROR, "Invalid chunk size %"PRIu64"\n",
                        s->chunksize);
                 return AVERROR(EINVAL);
@@ -1550,6 +1801,58 @@ static int http_shutdown(URLContext *h, int flags)
     return ret;
 }
 
+/* Return true if the server keeps the connection open and the whole reply
+ * has been read, so that another request can be sent on it. */
+static int http_reply_done(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+    uint64_t end;
+
+    if (s->willclose || s->listen || s->buf_ptr != s->buf_end)
+        return 0;
+    if (s->http_code == 204 || s->http_code == 304 ||
+        (s->method && !av_strcasecmp(s->method, "HEAD")))
+        return 1;
+    if (s->chunksize != UINT64_MAX)
+        return s->chunked_eof;
+    end = s->end_off && s->http_code == 206 ? s->end_off : s->filesize;
+    return end != UINT64_MAX && s->off == end;
+}
+
+/* Read the reply to a chunked upload and whatever body comes with it, so
+ * that the connection can be reused. */
+static int http_read_upload_reply(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+    uint8_t buf[1024];
+    int new_location, ret, total = 0;
+
+    if (!s->end_header && (ret = http_read_header(h, &new_location)) < 0)
+        return ret;
+    while ((ret = http_buf_read(h, buf, sizeof(buf))) > 0) {
+        /* give up on replies with a real body */
+        if ((total += ret) > BUFFER_SIZE)
+            return AVERROR(EINVAL);
+    }
+    return ret == AVERROR_EOF ? 0 : ret;
+}
+
+/* Give the connection back to the pool if possible, close it otherwise. */
+static void http_release_hd(URLContext *h)
+{
+    HTTPContext *s = h->priv_data;
+
+    if (s->keepalive && http_conn(s->hd) &&
+        (h->flags & AVIO_FLAG_WRITE) && s->chunked_post && s->end_chunked_post &&
+        http_read_upload_reply(h) < 0)
+        s->willclose = 1;
+
+    if (s->keepalive && http_reply_done(h) && http_pool_put(s, s->hd))
+        s->hd = NULL;
+    else
+        http_conn_close(&s->hd);
+}
+
 static int http_close(URLContext *h)
 {
     int ret = 0;
@@ -1565,7 +1868,7 @@ static int http_close(URLContext *h)
         ret = http_shutdown(h, h->flags);
 
     if (s->hd)
-        ffurl_closep(&s->hd);
+        http_release_hd(h);
     av_dict_free(&s->chained_options);
     return ret;
 }
@@ -1617,7 +1920,7 @@ static int64_t http_seek_internal(URLContext *h, int64_t off, int whence, int fo
         return ret;
     }
     av_dict_free(&options);
-    ffurl_close(old_hd);
+    http_conn_close(&old_hd);
     return off;
 }
 
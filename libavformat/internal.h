@@ -349,8 +349,33 @@ int ff_add_index_entry(AVIndexEntry **index_entries,
                        unsigned int *index_entries_allocated_size,
                        int64_t pos, int64_t timestamp, int size, int distance, int flags);
 
+/**
+ * Add several entries to the index of a stream at once.
+ *
+ * Adding n entries costs O(n + nb_index_entries) instead of up to
+ * O(n * nb_index_entries) for n calls to av_add_index_entry(), which is
+ * significant when the entries interleave with an existing index.
+ * Entries should be sorted by timestamp; any that are not are added one by
+ * one. Entries with the same timestamp replace each other as with
+ * av_add_index_entry(). min_distance holds the distance argument.
+ *
+ * @param entries entries to add, overwritten by this function
+ * @return 0 on success, a negative AVERROR code on failure
+ */
+int ff_add_index_entries(AVStream *st, AVIndexEntry *entries, int nb_entries);
+
 void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance);
 
+/**
+ * Same as ff_configure_buffers_for_index(), for demuxers which do not keep all
+ * the index entries of their streams in AVStream.index_entries.
+ *
+ * @param get_entry returns the index entry i of st, or NULL past the last
+ *                  one; the entries of each stream are requested in order
+ */
+void ff_configure_buffers_for_entries(AVFormatContext *s, int64_t time_tolerance,
+                                      AVIndexEntry *(*get_entry)(AVStream *st, int i));
+
 /**
  * Add a new chapter.
  *
@@ -127,6 +127,25 @@ typedef struct MOVIndexRange {
     int64_t end;
 } MOVIndexRange;
 
+/* consecutive chunks holding the same number of samples */
+typedef struct MOVSampleRun {
+    unsigned int first_chunk;
+    unsigned int first_sample;
+    unsigned int count;         ///< number of samples per chunk
+} MOVSampleRun;
+
+/* position of a sample in the sample tables */
+typedef struct MOVSampleCursor {
+    unsigned int sample;
+    unsigned int run;
+    unsigned int chunk;
+    unsigned int chunk_sample;
+    unsigned int stts_index;
+    unsigned int stts_sample;
+    int64_t pos;
+    int64_t dts;
+} MOVSampleCursor;
+
 typedef struct MOVStreamContext {
     AVIOContext *pb;
     int pb_is_copied;
@@ -161,6 +180,16 @@ typedef struct MOVStreamContext {
     int64_t current_index;
     MOVIndexRange* index_ranges;
     MOVIndexRange* current_index_range;
+    int lazy_index;       ///< samples are resolved from the sample tables when needed
+    MOVSampleRun *lazy_runs;
+    unsigned int lazy_runs_count;
+    unsigned int lazy_sample_count;
+    unsigned int lazy_first_sample; ///< first sample kept by the edit list
+    unsigned int lazy_discard_end;  ///< samples before this one are only decoded
+    int64_t lazy_start_dts;
+    int64_t lazy_edit_time;         ///< media time of the edit list entry
+    MOVSampleCursor lazy_cursor;
+    AVIndexEntry lazy_entry; ///< last sample resolved from the sample tables
     unsigned int bytes_per_frame;
     unsigned int samples_per_frame;
     int dv_audio_container;
@@ -239,6 +268,7 @@ typedef struct MOVContext {
     int use_absolute_path;
     int ignore_editlist;
     int advanced_editlist;
+    int lazy_index;
     int ignore_chapters;
     int seek_individually;
     int64_t next_root_atom; ///< offset of the next root atom
@@ -1651,8 +1651,11 @@ static void matroska_add_index_entries(MatroskaDemuxContext *matroska)
 {
     EbmlList *index_list;
     MatroskaIndex *index;
+    MatroskaTrack *tracks = matroska->tracks.elem;
+    AVIndexEntry *entries = NULL;
+    unsigned int entries_size = 0;
     uint64_t index_scale = 1;
-    int i, j;
+    int i, j, t;
 
     if (matroska->ctx->flags & AVFMT_FLAG_IGNIDX)
         return;
@@ -1665,19 +1668,40 @@ static void matroska_add_index_entries(MatroskaDemuxContext *matroska)
         av_log(matroska->ctx, AV_LOG_WARNING, "Dropping apparently-broken index.\n");
         return;
     }
-    for (i = 0; i < index_list->nb_elem; i++) {
-        EbmlList *pos_list    = &index[i].pos;
-        MatroskaIndexPos *pos = pos_list->elem;
-        for (j = 0; j < pos_list->nb_elem; j++) {
-            MatroskaTrack *track = matroska_find_track_by_num(matroska,
-                                                              pos[j].track);
-            if (track && track->stream)
-                av_add_index_entry(track->stream,
-                                   pos[j].pos + matroska->segment_start,
-                                   index[i].time / index_scale, 0, 0,
-                                   AVINDEX_KEYFRAME);
+    /* The cues may be parsed after cluster entries have been added during
+     * playback, so add them per track in one go rather than one by one. */
+    for (t = 0; t < matroska->tracks.nb_elem; t++) {
+        MatroskaTrack *track = &tracks[t];
+        int nb_entries = 0;
+
+        if (!track->stream ||
+            matroska_find_track_by_num(matroska, track->num) != track)
+            continue;
+        for (i = 0; i < index_list->nb_elem; i++) {
+            EbmlList *pos_list    = &index[i].pos;
+            MatroskaIndexPos *pos = pos_list->elem;
+            for (j = 0; j < pos_list->nb_elem; j++) {
+                AVIndexEntry *e;
+
+                if (pos[j].track != track->num)
+                    continue;
+                e = av_fast_realloc(entries, &entries_size,
+                                    (nb_entries + 1) * sizeof(*entries));
+                if (!e)
+                    goto end;
+                entries = e;
+                e = &entries[nb_entries++];
+                memset(e, 0, sizeof(*e));
+                e->pos       = pos[j].pos + matroska->segment_start;
+                e->timestamp = index[i].time / index_scale;
+                e->flags     = AVINDEX_KEYFRAME;
+            }
         }
+        if (nb_entries)
+            ff_add_index_entries(track->stream, entries, nb_entries);
     }
+end:
+    av_free(entries);
 }
 
 static void matroska_parse_cues(MatroskaDemuxContext *matroska) {
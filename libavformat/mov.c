@@ -3329,11 +3329,10 @@ static void mov_fix_index(MOVContext *mov, AVStream *st)
     msc->current_index = msc->index_ranges[0].start;
 }
 
-static void mov_build_index(MOVContext *mov, AVStream *st)
+static void mov_build_index_entries(MOVContext *mov, AVStream *st, int64_t current_dts)
 {
     MOVStreamContext *sc = st->priv_data;
     int64_t current_offset;
-    int64_t current_dts = 0;
     unsigned int stts_index = 0;
     unsigned int stsc_index = 0;
     unsigned int stss_index = 0;
@@ -3341,44 +3340,6 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
     unsigned int i, j;
     uint64_t stream_size = 0;
 
-    if (sc->elst_count) {
-        int i, edit_start_index = 0, multiple_edits = 0;
-        int64_t empty_duration = 0; // empty duration of the first edit list entry
-        int64_t start_time = 0; // start time of the media
-
-        for (i = 0; i < sc->elst_count; i++) {
-            const MOVElst *e = &sc->elst_data[i];
-            if (i == 0 && e->time == -1) {
-                /* if empty, the first entry is the start time of the stream
-                 * relative to the presentation itself */
-                empty_duration = e->duration;
-                edit_start_index = 1;
-            } else if (i == edit_start_index && e->time >= 0) {
-                start_time = e->time;
-            } else {
-                multiple_edits = 1;
-            }
-        }
-
-        if (multiple_edits && !mov->advanced_editlist)
-            av_log(mov->fc, AV_LOG_WARNING, "multiple edit list entries, "
-                   "Use -advanced_editlist to correctly decode otherwise "
-                   "a/v desync might occur\n");
-
-        /* adjust first dts according to edit list */
-        if ((empty_duration || start_time) && mov->time_scale > 0) {
-            if (empty_duration)
-                empty_duration = av_rescale(empty_duration, sc->time_scale, mov->time_scale);
-            sc->time_offset = start_time - empty_duration;
-            if (!mov->advanced_editlist)
-                current_dts = -sc->time_offset;
-        }
-
-        if (!multiple_edits && !mov->advanced_editlist &&
-            st->codecpar->codec_id == AV_CODEC_ID_AAC && start_time > 0)
-            sc->start_pad = start_time;
-    }
-
     /* only use old uncompressed audio chunk demuxing when stts specifies it */
     if (!(st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
           sc->stts_count == 1 && sc->stts_data[0].duration == 1)) {
@@ -3616,6 +3577,429 @@ static void mov_build_index(MOVContext *mov, AVStream *st)
     }
 }
 
+static unsigned int mov_lazy_sample_size(MOVStreamContext *sc, unsigned int sample)
+{
+    return sc->stsz_sample_size > 0 ? sc->stsz_sample_size : sc->sample_sizes[sample];
+}
+
+static void mov_lazy_set_sample(MOVStreamContext *sc, unsigned int sample)
+{
+    MOVSampleCursor *c = &sc->lazy_cursor;
+    const MOVSampleRun *run;
+    unsigned int a = 0, b = sc->lazy_runs_count, i;
+    int64_t dts = sc->lazy_start_dts;
+
+    while (b - a > 1) {
+        unsigned int m = (a + b) >> 1;
+        if (sc->lazy_runs[m].first_sample <= sample)
+            a = m;
+        else
+            b = m;
+    }
+    run = &sc->lazy_runs[a];
+    c->sample       = sample;
+    c->run          = a;
+    c->chunk        = run->first_chunk + (sample - run->first_sample) / run->count;
+    c->chunk_sample = (sample - run->first_sample) % run->count;
+    c->pos          = sc->chunk_offsets[c->chunk];
+    for (i = sample - c->chunk_sample; i < sample; i++)
+        c->pos += mov_lazy_sample_size(sc, i);
+
+    /* the last stts entry and the empty ones never end, as when building the index */
+    for (i = 0; i + 1 < sc->stts_count; i++) {
+        unsigned int count = sc->stts_data[i].count;
+        if (!count || sample < count)
+            break;
+        dts    += (int64_t)count * sc->stts_data[i].duration;
+        sample -= count;
+    }
+    c->stts_index  = i;
+    c->stts_sample = sample;
+    c->dts         = dts + (int64_t)sample * sc->stts_data[i].duration;
+}
+
+static void mov_lazy_next_sample(MOVStreamContext *sc)
+{
+    MOVSampleCursor *c = &sc->lazy_cursor;
+
+    c->pos += mov_lazy_sample_size(sc, c->sample);
+    c->dts += sc->stts_data[c->stts_index].duration;
+    c->stts_sample++;
+    if (c->stts_index + 1 < sc->stts_count &&
+        c->stts_sample == sc->stts_data[c->stts_index].count) {
+        c->stts_sample = 0;
+        c->stts_index++;
+    }
+
+    c->sample++;
+    if (c->run + 1 < sc->lazy_runs_count &&
+        c->sample == sc->lazy_runs[c->run + 1].first_sample) {
+        c->run++;
+        c->chunk        = sc->lazy_runs[c->run].first_chunk;
+        c->chunk_sample = 0;
+        c->pos          = sc->chunk_offsets[c->chunk];
+    } else if (++c->chunk_sample == sc->lazy_runs[c->run].count) {
+        c->chunk++;
+        c->chunk_sample = 0;
+        if (c->chunk < sc->chunk_count)
+            c->pos = sc->chunk_offsets[c->chunk];
+    }
+}
+
+/**
+ * Find the closest keyframe at or before (backward) or at or after sample,
+ * counting from the first sample of the sample tables.
+ * @return the keyframe, -1 or the number of samples if there is none
+ */
+static int64_t mov_lazy_find_keyframe(AVStream *st, int64_t sample, int backward)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t nb_samples = sc->lazy_first_sample + sc->lazy_sample_count;
+    int key_off = sc->keyframe_count && sc->keyframes[0] > 0;
+    int a = -1, b = sc->keyframe_count;
+
+    if (sc->keyframe_absent) {
+        if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO || !sample)
+            return sample;
+        return backward ? 0 : nb_samples;
+    }
+    if (!sc->keyframe_count)
+        return sample;
+
+    while (b - a > 1) {
+        int m = (a + b) >> 1;
+        if (sc->keyframes[m] - key_off <= sample)
+            a = m;
+        else
+            b = m;
+    }
+    if (backward)
+        return a < 0 ? -1 : sc->keyframes[a] - key_off;
+    if (a >= 0 && sc->keyframes[a] - key_off == sample)
+        return sample;
+    return b < sc->keyframe_count ? sc->keyframes[b] - key_off : nb_samples;
+}
+
+static AVIndexEntry *mov_lazy_get_sample(AVStream *st, int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+    MOVSampleCursor *c = &sc->lazy_cursor;
+    AVIndexEntry *e = &sc->lazy_entry;
+
+    if (sample < 0 || sample >= sc->lazy_sample_count)
+        return NULL;
+    sample += sc->lazy_first_sample;
+
+    /* demuxing only moves forward by one sample at a time */
+    if (sample > c->sample && sample - c->sample <= 16) {
+        while (c->sample < sample)
+            mov_lazy_next_sample(sc);
+    } else if (sample != c->sample) {
+        mov_lazy_set_sample(sc, sample);
+    }
+
+    e->pos          = c->pos;
+    e->timestamp    = c->dts;
+    e->size         = mov_lazy_sample_size(sc, sample);
+    e->min_distance = 0;
+    e->flags        = mov_lazy_find_keyframe(st, sample, 1) == sample ? AVINDEX_KEYFRAME : 0;
+    if (sample < sc->lazy_discard_end)
+        e->flags   |= AVINDEX_DISCARD_FRAME;
+    return e;
+}
+
+/* Same as av_index_search_timestamp() on the index mov_build_index_entries() would build. */
+static int mov_lazy_search_timestamp(AVStream *st, int64_t timestamp, int flags)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t first = sc->lazy_first_sample, sample = 0, m;
+    int64_t nb_samples = first + sc->lazy_sample_count;
+    int64_t dts = sc->lazy_start_dts;
+    unsigned int i;
+
+    /* first sample with a dts not below timestamp */
+    for (i = 0; sample < nb_samples; i++) {
+        int64_t duration = sc->stts_data[i].duration;
+        int64_t count    = sc->stts_data[i].count;
+
+        if (i + 1 == sc->stts_count || !count || count > nb_samples - sample)
+            count = nb_samples - sample;
+        if (timestamp <= dts)
+            break;
+        if (duration > 0 && timestamp <= dts + (count - 1) * duration) {
+            int64_t skip = (timestamp - dts + duration - 1) / duration;
+            sample += skip;
+            dts    += skip * duration;
+            break;
+        }
+        sample += count;
+        dts    += count * duration;
+    }
+
+    /* the samples before the first one kept by the edit list are not in the index */
+    if (flags & AVSEEK_FLAG_BACKWARD)
+        m = sample < nb_samples && dts == timestamp ? sample : sample - 1;
+    else
+        m = FFMAX(sample, first);
+
+    if (!(flags & AVSEEK_FLAG_ANY) && m >= first && m < nb_samples)
+        m = mov_lazy_find_keyframe(st, m, flags & AVSEEK_FLAG_BACKWARD);
+
+    if (m < first || m >= nb_samples)
+        return -1;
+    return m - first;
+}
+
+/**
+ * Apply a single edit list entry starting at the media time edit_time > 0 to
+ * the samples resolved lazily, the same way mov_fix_index() does: the samples
+ * before the keyframe preceding it are dropped, the timestamps are shifted by
+ * edit_time and the audio samples before it are only decoded.
+ *
+ * @return 0 if the edit was applied, a negative value if it needs the AVIndex
+ */
+static int mov_lazy_apply_edit(AVStream *st, int64_t edit_time)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t search = edit_time, first, start, start_dts;
+    unsigned int i;
+
+    /* vorbis is never trimmed partially and equal timestamps would need the
+     * backward search of find_prev_closest_index() */
+    if (st->codecpar->codec_id == AV_CODEC_ID_VORBIS)
+        return -1;
+    for (i = 0; i < sc->stts_count; i++)
+        if (sc->stts_data[i].duration <= 0)
+            return -1;
+
+    /* audio decoders need the samples up to 1 second before the edit */
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO)
+        search = FFMAX(search - sc->time_scale, sc->lazy_start_dts);
+    first = mov_lazy_search_timestamp(st, search, AVSEEK_FLAG_BACKWARD);
+    if (first < 0)
+        first = mov_lazy_search_timestamp(st, search, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_ANY);
+    /* first sample starting at or after the edit */
+    start = mov_lazy_search_timestamp(st, edit_time, AVSEEK_FLAG_ANY);
+    if (first < 0 || start <= 0)
+        return -1;
+    mov_lazy_set_sample(sc, start);
+
+    if (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO) {
+        /* a sample overlapping the start of the edit is trimmed by the decoder */
+        if (sc->lazy_cursor.dts > edit_time)
+            mov_lazy_set_sample(sc, --start);
+        start_dts = sc->lazy_cursor.dts;
+        mov_lazy_set_sample(sc, first);
+        st->skip_samples = edit_time - sc->lazy_cursor.dts;
+        sc->start_pad    = start_dts - sc->lazy_cursor.dts;
+    } else if (start != first || sc->lazy_cursor.dts != edit_time) {
+        /* video frames before the edit would all get its start timestamp */
+        return -1;
+    }
+
+    sc->lazy_first_sample  = first;
+    sc->lazy_discard_end   = start;
+    sc->lazy_sample_count -= first;
+    sc->lazy_start_dts    -= edit_time;
+    sc->lazy_edit_time     = edit_time;
+    return 0;
+}
+
+/**
+ * Prepare resolving the samples of st from its sample tables instead of
+ * building its AVIndex, if its sample tables allow it.
+ *
+ * @return 1 if the samples of st are resolved lazily
+ */
+static int mov_lazy_index_init(MOVContext *mov, AVStream *st, int64_t start_dts)
+{
+    MOVStreamContext *sc = st->priv_data;
+    unsigned int stsc_index = 0, last_chunk = 0, i;
+    int64_t nb_samples = 0, edit_time = 0, edit_duration = -1;
+    uint64_t stream_size = 0;
+
+    if (sc->elst_count && !mov->ignore_editlist && mov->advanced_editlist) {
+        /* a single edit covering the samples up to the last one is applied
+         * by mov_lazy_apply_edit(), anything else needs mov_fix_index() */
+        if (sc->elst_count > 1 || sc->elst_data[0].time < 0 || sc->ctts_count ||
+            sc->dts_shift || mov->time_scale <= 0)
+            return 0;
+        edit_time     = sc->elst_data[0].time;
+        edit_duration = av_rescale(sc->elst_data[0].duration, sc->time_scale,
+                                   mov->time_scale);
+    }
+
+    /* partial sync samples and pseudo streams need the AVIndex */
+    if ((st->codecpar->codec_type != AVMEDIA_TYPE_VIDEO &&
+         st->codecpar->codec_type != AVMEDIA_TYPE_AUDIO) ||
+        sc->stps_count || (sc->rap_group_count && sc->rap_group) ||
+        st->nb_index_entries ||
+        !sc->sample_count || !sc->chunk_count || !sc->stsc_count || !sc->stts_count ||
+        (st->codecpar->codec_type == AVMEDIA_TYPE_AUDIO &&
+         sc->stts_count == 1 && sc->stts_data[0].duration == 1))
+        return 0;
+    for (i = 0; i < sc->stts_count; i++)
+        if (sc->stts_data[i].duration < 0)
+            return 0;
+    if (sc->pseudo_stream_id != -1)
+        for (i = 0; i < sc->stsc_count; i++)
+            if (sc->stsc_data[i].id - 1 != sc->pseudo_stream_id)
+                return 0;
+
+    sc->lazy_runs = av_malloc_array(sc->stsc_count, sizeof(*sc->lazy_runs));
+    if (!sc->lazy_runs)
+        return 0;
+    sc->lazy_runs_count = 0;
+
+    for (i = 0; i < sc->chunk_count && nb_samples < sc->sample_count; i++) {
+        int64_t next_offset = i+1 < sc->chunk_count ? sc->chunk_offsets[i+1] : INT64_MAX;
+        int64_t current_offset = sc->chunk_offsets[i];
+        unsigned int count;
+
+        while (mov_stsc_index_valid(stsc_index, sc->stsc_count) &&
+            i + 1 == sc->stsc_data[stsc_index + 1].first)
+            stsc_index++;
+
+        if (next_offset > current_offset && sc->sample_size>0 && sc->sample_size < sc->stsz_sample_size &&
+            sc->stsc_data[stsc_index].count * (int64_t)sc->stsz_sample_size > next_offset - current_offset) {
+            av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too large), ignoring\n", sc->stsz_sample_size);
+            sc->stsz_sample_size = sc->sample_size;
+        }
+        if (sc->stsz_sample_size>0 && sc->stsz_sample_size < sc->sample_size) {
+            av_log(mov->fc, AV_LOG_WARNING, "STSZ sample size %d invalid (too small), ignoring\n", sc->stsz_sample_size);
+            sc->stsz_sample_size = sc->sample_size;
+        }
+
+        count = sc->stsc_data[stsc_index].count;
+        if (!count)
+            continue;
+        if (!sc->lazy_runs_count || last_chunk + 1 != i ||
+            sc->lazy_runs[sc->lazy_runs_count - 1].count != count) {
+            MOVSampleRun *run = &sc->lazy_runs[sc->lazy_runs_count++];
+            run->first_chunk  = i;
+            run->first_sample = nb_samples;
+            run->count        = count;
+        }
+        last_chunk  = i;
+        nb_samples += count;
+    }
+    nb_samples = FFMIN(nb_samples, sc->sample_count);
+
+    /* leave reporting broken sample sizes to mov_build_index_entries() */
+    if (sc->stsz_sample_size > 0) {
+        if (sc->stsz_sample_size > 0x3FFFFFFF)
+            goto fail;
+        stream_size = (uint64_t)sc->stsz_sample_size * nb_samples;
+    } else {
+        for (i = 0; i < nb_samples; i++) {
+            if ((unsigned)sc->sample_sizes[i] > 0x3FFFFFFF)
+                goto fail;
+            stream_size += (unsigned)sc->sample_sizes[i];
+        }
+    }
+    if (st->duration > 0)
+        st->codecpar->bit_rate = stream_size*8*sc->time_scale/st->duration;
+
+    sc->lazy_sample_count = nb_samples;
+    sc->lazy_first_sample = 0;
+    sc->lazy_discard_end  = 0;
+    sc->lazy_start_dts    = start_dts - sc->dts_shift;
+    sc->lazy_edit_time    = 0;
+    if (edit_time > 0 && mov_lazy_apply_edit(st, edit_time) < 0)
+        goto fail;
+    if (edit_duration >= 0) {
+        mov_lazy_set_sample(sc, nb_samples - 1);
+        if (sc->lazy_cursor.dts >= edit_duration)
+            goto fail;
+        st->duration = edit_duration;
+    }
+    sc->lazy_index = 1;
+    mov_lazy_set_sample(sc, sc->lazy_first_sample);
+    av_log(mov->fc, AV_LOG_DEBUG, "stream %d: %u samples in %u runs\n",
+           st->index, sc->lazy_sample_count, sc->lazy_runs_count);
+
+    return 1;
+fail:
+    av_freep(&sc->lazy_runs);
+    return 0;
+}
+
+/* Build the AVIndex of a stream whose samples were resolved lazily. */
+static void mov_lazy_index_build(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    sc->lazy_index = 0;
+    av_freep(&sc->lazy_runs);
+    mov_build_index_entries(mov, st, sc->lazy_start_dts + sc->dts_shift + sc->lazy_edit_time);
+
+    av_freep(&sc->chunk_offsets);
+    av_freep(&sc->sample_sizes);
+    av_freep(&sc->keyframes);
+    av_freep(&sc->stts_data);
+    av_freep(&sc->elst_data);
+}
+
+static AVIndexEntry *mov_get_sample(AVStream *st, int sample)
+{
+    MOVStreamContext *sc = st->priv_data;
+
+    if (sc->lazy_index)
+        return mov_lazy_get_sample(st, sample);
+    if (sample < 0 || sample >= st->nb_index_entries)
+        return NULL;
+    return &st->index_entries[sample];
+}
+
+static void mov_build_index(MOVContext *mov, AVStream *st)
+{
+    MOVStreamContext *sc = st->priv_data;
+    int64_t current_dts = 0;
+
+    if (sc->elst_count) {
+        int i, edit_start_index = 0, multiple_edits = 0;
+        int64_t empty_duration = 0; // empty duration of the first edit list entry
+        int64_t start_time = 0; // start time of the media
+
+        for (i = 0; i < sc->elst_count; i++) {
+            const MOVElst *e = &sc->elst_data[i];
+            if (i == 0 && e->time == -1) {
+                /* if empty, the first entry is the start time of the stream
+                 * relative to the presentation itself */
+                empty_duration = e->duration;
+                edit_start_index = 1;
+            } else if (i == edit_start_index && e->time >= 0) {
+                start_time = e->time;
+            } else {
+                multiple_edits = 1;
+            }
+        }
+
+        if (multiple_edits && !mov->advanced_editlist)
+            av_log(mov->fc, AV_LOG_WARNING, "multiple edit list entries, "
+                   "Use -advanced_editlist to correctly decode otherwise "
+                   "a/v desync might occur\n");
+
+        /* adjust first dts according to edit list */
+        if ((empty_duration || start_time) && mov->time_scale > 0) {
+            if (empty_duration)
+                empty_duration = av_rescale(empty_duration, sc->time_scale, mov->time_scale);
+            sc->time_offset = start_time - empty_duration;
+            if (!mov->advanced_editlist)
+                current_dts = -sc->time_offset;
+        }
+
+        if (!multiple_edits && !mov->advanced_editlist &&
+            st->codecpar->codec_id == AV_CODEC_ID_AAC && start_time > 0)
+            sc->start_pad = start_time;
+    }
+
+    if (mov->lazy_index && mov_lazy_index_init(mov, st, current_dts))
+        return;
+
+    mov_build_index_entries(mov, st, current_dts);
+}
+
 static int test_same_origin(const char *src, const char *ref) {
     char src_proto[64];
     char ref_proto[64];
@@ -3831,13 +4215,15 @@ static int mov_read_trak(MOVContext *c, AVIOContext *pb, MOVAtom atom)
         && sc->time_scale == st->codecpar->sample_rate) {
             st->need_parsing = AVSTREAM_PARSE_FULL;
     }
-    /* Do not need those anymore. */
-    av_freep(&sc->chunk_offsets);
-    av_freep(&sc->sample_sizes);
-    av_freep(&sc->keyframes);
-    av_freep(&sc->stts_data);
+    /* Do not need those anymore, unless the samples are resolved lazily. */
+    if (!sc->lazy_index) {
+        av_freep(&sc->chunk_offsets);
+        av_freep(&sc->sample_sizes);
+        av_freep(&sc->keyframes);
+        av_freep(&sc->stts_data);
+        av_freep(&sc->elst_data);
+    }
     av_freep(&sc->stps_data);
-    av_freep(&sc->elst_data);
     av_freep(&sc->rap_group);
 
     return 0;
@@ -5957,6 +6343,7 @@ static int mov_read_close(AVFormatContext *s)
         av_freep(&sc->rap_group);
         av_freep(&sc->display_matrix);
         av_freep(&sc->index_ranges);
+        av_freep(&sc->lazy_runs);
 
         if (sc->extradata)
             for (j = 0; j < sc->stsd_count; j++)
@@ -6181,6 +6568,25 @@ static int mov_read_header(AVFormatContext *s)
     }
     av_log(mov->fc, AV_LOG_TRACE, "on_parse_exit_offset=%"PRId64"\n", avio_tell(pb));
 
+    for (i = 0; i < s->nb_streams; i++) {
+        AVStream *st = s->streams[i];
+        MOVStreamContext *sc = st->priv_data;
+        int chapter_track = 0;
+
+        if (!sc->lazy_index)
+            continue;
+        for (j = 0; j < mov->nb_chapter_tracks; j++)
+            if (mov->chapter_tracks[j] == st->id)
+                chapter_track = 1;
+        /* fragments and chapters are read through the AVIndex */
+        if (mov->trex_count || chapter_track) {
+            mov_lazy_index_build(mov, st);
+        } else if (st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            for (j = 0; j < FFMIN(sc->lazy_sample_count, 99); j++)
+                ff_rfps_add_frame(s, st, mov_lazy_get_sample(st, j)->timestamp);
+        }
+    }
+
     if (pb->seekable & AVIO_SEEKABLE_NORMAL) {
         if (mov->nb_chapter_tracks > 0 && !mov->ignore_chapters)
             mov_read_chapters(s);
@@ -6343,7 +6749,7 @@ static int mov_read_header(AVFormatContext *s)
             break;
         }
     }
-    ff_configure_buffers_for_index(s, AV_TIME_BASE);
+    ff_configure_buffers_for_entries(s, AV_TIME_BASE, mov_get_sample);
 
     return 0;
 }
@@ -6356,8 +6762,8 @@ static AVIndexEntry *mov_find_next_sample(AVFormatContext *s, AVStream **st)
     for (i = 0; i < s->nb_streams; i++) {
         AVStream *avst = s->streams[i];
         MOVStreamContext *msc = avst->priv_data;
-        if (msc->pb && msc->current_sample < avst->nb_index_entries) {
-            AVIndexEntry *current_sample = &avst->index_entries[msc->current_sample];
+        AVIndexEntry *current_sample;
+        if (msc->pb && (current_sample = mov_get_sample(avst, msc->current_sample))) {
             int64_t dts = av_rescale(current_sample->timestamp, AV_TIME_BASE, msc->time_scale);
             av_log(s, AV_LOG_TRACE, "stream %d, sample %d, dts %"PRId64"\n", i, msc->current_sample, dts);
             if (!sample || (!(s->pb->seekable & AVIO_SEEKABLE_NORMAL) && current_sample->pos < sample->pos) ||
@@ -6454,7 +6860,7 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
 {
     MOVContext *mov = s->priv_data;
     MOVStreamContext *sc;
-    AVIndexEntry *sample;
+    AVIndexEntry *sample, lazy_sample;
     AVStream *st = NULL;
     int64_t current_index;
     int ret;
@@ -6469,6 +6875,11 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
         goto retry;
     }
     sc = st->priv_data;
+    if (sc->lazy_index) {
+        /* resolving the next sample overwrites the entry */
+        lazy_sample = *sample;
+        sample = &lazy_sample;
+    }
     /* must be done just before reading, to avoid infinite loop on sample */
     current_index = sc->current_index;
     mov_current_sample_inc(sc);
@@ -6543,8 +6954,8 @@ static int mov_read_packet(AVFormatContext *s, AVPacket *pkt)
             sc->ctts_sample = 0;
         }
     } else {
-        int64_t next_dts = (sc->current_sample < st->nb_index_entries) ?
-            st->index_entries[sc->current_sample].timestamp : st->duration;
+        AVIndexEntry *next_sample = mov_get_sample(st, sc->current_sample);
+        int64_t next_dts = next_sample ? next_sample->timestamp : st->duration;
         pkt->duration = next_dts - pkt->dts;
         pkt->pts = pkt->dts;
     }
@@ -6614,6 +7025,7 @@ static int mov_seek_fragment(AVFormatContext *s, AVStream *st, int64_t timestamp
 static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp, int flags)
 {
     MOVStreamContext *sc = st->priv_data;
+    AVIndexEntry *first_sample;
     int sample, time_sample;
     int i;
 
@@ -6621,9 +7033,13 @@ static int mov_seek_stream(AVFormatContext *s, AVStream *st, int64_t timestamp,
     if (ret < 0)
         return ret;
 
-    sample = av_index_search_timestamp(st, timestamp, flags);
+    if (sc->lazy_index)
+        sample = mov_lazy_search_timestamp(st, timestamp, flags);
+    else
+        sample = av_index_search_timestamp(st, timestamp, flags);
     av_log(s, AV_LOG_TRACE, "stream %d, timestamp %"PRId64", sample %d\n", st->index, timestamp, sample);
-    if (sample < 0 && st->nb_index_entries && timestamp < st->index_entries[0].timestamp)
+    first_sample = mov_get_sample(st, 0);
+    if (sample < 0 && first_sample && timestamp < first_sample->timestamp)
         sample = 0;
     if (sample < 0) /* not sure what to do */
         return AVERROR_INVALIDDATA;
@@ -6675,7 +7091,7 @@ static int mov_read_seek(AVFormatContext *s, int stream_index, int64_t sample_ti
 
     if (mc->seek_individually) {
         /* adjust seek timestamp to found sample timestamp */
-        int64_t seek_timestamp = st->index_entries[sample].timestamp;
+        int64_t seek_timestamp = mov_get_sample(st, sample)->timestamp;
 
         for (i = 0; i < s->nb_streams; i++) {
             int64_t timestamp;
@@ -6729,6 +7145,10 @@ static const AVOption mov_options[] = {
         0, 1, FLAGS},
     {"ignore_chapters", "", OFFSET(ignore_chapters), AV_OPT_TYPE_BOOL, {.i64 = 0},
         0, 1, FLAGS},
+    {"lazy_index",
+        "Resolve samples from the sample tables when they are read instead of building the AVIndex.",
+        OFFSET(lazy_index), AV_OPT_TYPE_BOOL, {.i64 = 0},
+        0, 1, FLAGS},
     {"use_mfra_for",
         "use mfra for fragment timestamps",
         OFFSET(use_mfra_for), AV_OPT_TYPE_INT, {.i64 = FF_MOV_FLAG_MFRA_AUTO},
@@ -28,6 +28,7 @@
 #include "libavutil/mathematics.h"
 #include "libavutil/opt.h"
 #include "libavutil/avassert.h"
+#include "libavutil/thread.h"
 #include "libavcodec/bytestream.h"
 #include "libavcodec/get_bits.h"
 #include "libavcodec/opus.h"
@@ -46,6 +47,10 @@
 
 #define MAX_MP4_DESCR_COUNT 16
 
+#define MAX_PES_THREADS 64
+#define MAX_PES_JOBS    1024
+#define PES_JOB_BATCH   64
+
 #define MOD_UNLIKELY(modulus, dividend, divisor, prev_dividend)                \
     do {                                                                       \
         if ((prev_dividend) == 0 || (dividend) - (prev_dividend) != (divisor)) \
@@ -159,6 +164,20 @@ struct MpegTSContext {
     /** filters for various streams specified by PMT + for the PAT and PMT */
     MpegTSFilter *pids[NB_PID_MAX];
     int current_pid;
+
+    int pes_threads;
+#if HAVE_THREADS
+    /* PES assembly threads. PES packets of streams that are not probed and
+     * need no other stream are assembled by the worker owning their PID,
+     * everything else is handled on the reading thread. The mutex protects
+     * the job rings of the workers and the output list. */
+    struct PESWorker *workers;
+    int nb_workers;
+    pthread_mutex_t worker_mutex;
+    pthread_cond_t worker_cond;   ///< signalled when a worker finished jobs
+    struct PESOutput *output;     ///< packets by TS packet number
+    int64_t packet_seq;           ///< number of the TS packet being handled
+#endif
 };
 
 #define MPEGTS_OPTIONS \
@@ -176,6 +195,8 @@ static const AVOption options[] = {
      {.i64 = 0}, 0, 1, 0 },
     {"skip_clear", "skip clearing programs", offsetof(MpegTSContext, skip_clear), AV_OPT_TYPE_BOOL,
      {.i64 = 0}, 0, 1, 0 },
+    {"pes_threads", "number of threads assembling PES packets, only helps with many large PES streams on multi-core machines", offsetof(MpegTSContext, pes_threads), AV_OPT_TYPE_INT,
+     {.i64 = 0}, 0, MAX_PES_THREADS, AV_OPT_FLAG_DECODING_PARAM },
     { NULL },
 };
 
@@ -241,10 +262,90 @@ typedef struct PESContext {
     uint8_t header[MAX_PES_HEADER_SIZE];
     AVBufferRef *buffer;
     SLConfigDescr sl;
+    struct PESJob *job; ///< job being run by a worker, see handle_packet()
+    int threaded;       ///< the last TS packet was given to a worker
 } PESContext;
 
+#if HAVE_THREADS
+/* one TS packet payload for a PES filter, and its result */
+typedef struct PESJob {
+    MpegTSFilter *filter;
+    int64_t seq;
+    int64_t pos;
+    int is_start;
+    int corrupt;
+    int discard;
+    int size;
+    uint8_t data[TS_PACKET_SIZE];
+    AVPacket pkt;
+    int stop_parse;
+    int ret;
+} PESJob;
+
+typedef struct PESOutput {
+    AVPacket pkt;
+    int64_t seq;
+    int ret;
+    struct PESOutput *next;
+} PESOutput;
+
+typedef struct PESWorker {
+    MpegTSContext *ts;
+    pthread_t thread;
+    pthread_cond_t cond;
+    /* jobs[job_head] is the oldest one not finished. The reading thread
+     * fills up to PES_JOB_BATCH jobs from job_tail on before adding them
+     * to nb_jobs, with nb_jobs <= MAX_PES_JOBS - PES_JOB_BATCH. */
+    PESJob jobs[MAX_PES_JOBS];
+    int job_head;
+    int nb_jobs;
+    int job_tail;
+    int nb_queued;
+    int abort;
+} PESWorker;
+#endif
+
 extern AVInputFormat ff_mpegts_demuxer;
 
+#if HAVE_THREADS
+/* Give the queued jobs to the workers, with worker_mutex held. */
+static void publish_pes_jobs(MpegTSContext *ts)
+{
+    int i;
+
+    for (i = 0; i < ts->nb_workers; i++) {
+        PESWorker *w = &ts->workers[i];
+
+        if (!w->nb_queued)
+            continue;
+        if (!w->nb_jobs)
+            pthread_cond_signal(&w->cond);
+        w->nb_jobs  += w->nb_queued;
+        w->nb_queued = 0;
+        while (w->nb_jobs > MAX_PES_JOBS - PES_JOB_BATCH)
+            pthread_cond_wait(&ts->worker_cond, &ts->worker_mutex);
+    }
+}
+#endif
+
+/* Wait until the PES workers have finished all their jobs. */
+static void wait_for_workers(MpegTSContext *ts)
+{
+#if HAVE_THREADS
+    int i;
+
+    if (!ts->nb_workers)
+        return;
+
+    pthread_mutex_lock(&ts->worker_mutex);
+    publish_pes_jobs(ts);
+    for (i = 0; i < ts->nb_workers; i++)
+        while (ts->workers[i].nb_jobs)
+            pthread_cond_wait(&ts->worker_cond, &ts->worker_mutex);
+    pthread_mutex_unlock(&ts->worker_mutex);
+#endif
+}
+
 static struct Program * get_program(MpegTSContext *ts, unsigned int programid)
 {
     int i;
@@ -434,6 +535,8 @@ static void write_section_data(MpegTSContext *ts, MpegTSFilter *tss1,
                 crc_valid = 2;
         }
         if (crc_valid) {
+            /* section callbacks may change or close any filter */
+            wait_for_workers(ts);
             tss->section_cb(tss1, tss->section_buf, tss->section_h_size);
             if (crc_valid != 1)
                 tss->last_ver = -1;
@@ -1003,6 +1106,12 @@ static int read_sl_header(PESContext *pes, SLConfigDescr *sl,
     return (get_bits_count(&gb) + 7) >> 3;
 }
 
+static int pes_discarded(PESContext *pes)
+{
+    return pes->st && pes->st->discard == AVDISCARD_ALL &&
+           (!pes->sub_st || pes->sub_st->discard == AVDISCARD_ALL);
+}
+
 /* return non zero if a packet could be constructed */
 static int mpegts_push_data(MpegTSFilter *filter,
                             const uint8_t *buf, int buf_size, int is_start,
@@ -1010,18 +1119,34 @@ static int mpegts_push_data(MpegTSFilter *filter,
 {
     PESContext *pes   = filter->u.pes_filter.opaque;
     MpegTSContext *ts = pes->ts;
+    AVPacket *pkt;
     const uint8_t *p;
-    int ret, len, code;
+    int ret, len, code, discard, *stop_parse;
+
+#if HAVE_THREADS
+    /* a worker must not look at the context, nor at the stream discard
+     * flags which the caller may change meanwhile */
+    if (pes->job) {
+        pkt        = &pes->job->pkt;
+        stop_parse = &pes->job->stop_parse;
+        discard    = pes->job->discard;
+    } else
+#endif
+    {
+        pkt        = ts->pkt;
+        stop_parse = &ts->stop_parse;
+        discard    = pes_discarded(pes);
+    }
 
-    if (!ts->pkt)
+    if (!pkt)
         return 0;
 
     if (is_start) {
         if (pes->state == MPEGTS_PAYLOAD && pes->data_index > 0) {
-            ret = new_pes_packet(pes, ts->pkt);
+            ret = new_pes_packet(pes, pkt);
             if (ret < 0)
                 return ret;
-            ts->stop_parse = 1;
+            *stop_parse = 1;
         } else {
             reset_pes_packet_state(pes);
         }
@@ -1050,10 +1175,7 @@ static int mpegts_push_data(MpegTSFilter *filter,
                             code);
                     pes->stream_id = pes->header[3];
 
-                    if ((pes->st && pes->st->discard == AVDISCARD_ALL &&
-                         (!pes->sub_st ||
-                          pes->sub_st->discard == AVDISCARD_ALL)) ||
-                        code == 0x1be) /* padding_stream */
+                    if (discard || code == 0x1be) /* padding_stream */
                         goto skip;
 
                     /* stream not present in PMT */
@@ -1232,7 +1354,7 @@ skip:
             if (pes->buffer) {
                 if (pes->data_index > 0 &&
                     pes->data_index + buf_size > pes->total_size) {
-                    ret = new_pes_packet(pes, ts->pkt);
+                    ret = new_pes_packet(pes, pkt);
                     if (ret < 0)
                         return ret;
                     pes->total_size = MAX_PES_PAYLOAD;
@@ -1240,7 +1362,7 @@ skip:
                                                   AV_INPUT_BUFFER_PADDING_SIZE);
                     if (!pes->buffer)
                         return AVERROR(ENOMEM);
-                    ts->stop_parse = 1;
+                    *stop_parse = 1;
                 } else if (pes->data_index == 0 &&
                            buf_size > pes->total_size) {
                     // pes packet size is < ts size packet and pes data is padded with 0xff
@@ -1254,10 +1376,10 @@ skip:
                  * a couple of seconds to milliseconds for properly muxed files.
                  * total_size is the number of bytes following pes_packet_length
                  * in the pes header, i.e. not counting the first PES_START_SIZE bytes */
-                if (!ts->stop_parse && pes->total_size < MAX_PES_PAYLOAD &&
+                if (!*stop_parse && pes->total_size < MAX_PES_PAYLOAD &&
                     pes->pes_header_size + pes->data_index == pes->total_size + PES_START_SIZE) {
-                    ts->stop_parse = 1;
-                    ret = new_pes_packet(pes, ts->pkt);
+                    *stop_parse = 1;
+                    ret = new_pes_packet(pes, pkt);
                     if (ret < 0)
                         return ret;
                 }
@@ -2246,12 +2368,256 @@ static void sdt_cb(MpegTSFilter *filter, const uint8_t *section, int section_len
 static int parse_pcr(int64_t *ppcr_high, int *ppcr_low,
                      const uint8_t *packet);
 
+#if HAVE_THREADS
+/* Whether the PES packets of a filter can be assembled by a worker, which
+ * must not touch anything outside of the PESContext. */
+static int pes_threadable(MpegTSContext *ts, MpegTSFilter *tss)
+{
+    PESContext *pes = tss->u.pes_filter.opaque;
+
+    if (!pes->st || pes->st->request_probe > 0 ||
+        pes->st->codecpar->codec_id == AV_CODEC_ID_NONE)
+        return 0;
+    /* SL headers set the stream time base */
+    if (pes->stream_type == 0x12)
+        return 0;
+    /* teletext and subtitle timestamps are fixed up from another stream */
+    if (ts->fix_teletext_pts &&
+        (pes->st->codecpar->codec_id == AV_CODEC_ID_DVB_TELETEXT ||
+         pes->st->codecpar->codec_id == AV_CODEC_ID_DVB_SUBTITLE))
+        return 0;
+    return 1;
+}
+
+/* Insert an output in TS packet order, with worker_mutex held. */
+static void insert_pes_output(MpegTSContext *ts, PESOutput *o)
+{
+    PESOutput **next = &ts->output;
+
+    while (*next && (*next)->seq < o->seq)
+        next = &(*next)->next;
+    o->next = *next;
+    *next   = o;
+}
+
+static int queue_pes_output(MpegTSContext *ts, AVPacket *pkt, int64_t seq,
+                            int ret)
+{
+    PESOutput *o = av_mallocz(sizeof(*o));
+
+    if (!o) {
+        av_packet_unref(pkt);
+        return AVERROR(ENOMEM);
+    }
+    o->seq = seq;
+    o->ret = ret;
+    av_init_packet(&o->pkt);
+    if (ret >= 0) {
+        /* section data is not reference counted */
+        o->ret = av_packet_ref(&o->pkt, pkt);
+        av_packet_unref(pkt);
+    }
+
+    pthread_mutex_lock(&ts->worker_mutex);
+    insert_pes_output(ts, o);
+    pthread_mutex_unlock(&ts->worker_mutex);
+    return 0;
+}
+
+/* Take the first output if no worker can still produce an earlier one. */
+static PESOutput *pop_pes_output(MpegTSContext *ts)
+{
+    PESOutput *o;
+    int i;
+
+    pthread_mutex_lock(&ts->worker_mutex);
+    publish_pes_jobs(ts);
+    o = ts->output;
+    for (i = 0; o && i < ts->nb_workers; i++) {
+        PESWorker *w = &ts->workers[i];
+        if (w->nb_jobs && w->jobs[w->job_head].seq < o->seq)
+            o = NULL;
+    }
+    if (o)
+        ts->output = o->next;
+    pthread_mutex_unlock(&ts->worker_mutex);
+    return o;
+}
+
+static void free_pes_outputs(MpegTSContext *ts)
+{
+    while (ts->output) {
+        PESOutput *o = ts->output;
+        ts->output = o->next;
+        av_packet_unref(&o->pkt);
+        av_free(o);
+    }
+}
+
+static void run_pes_job(PESJob *job)
+{
+    MpegTSFilter *tss = job->filter;
+    PESContext *pes   = tss->u.pes_filter.opaque;
+
+    if (job->corrupt)
+        pes->flags |= AV_PKT_FLAG_CORRUPT;
+    job->stop_parse = 0;
+    pes->job = job;
+    job->ret = tss->u.pes_filter.pes_cb(tss, job->data, job->size,
+                                        job->is_start, job->pos);
+    pes->job = NULL;
+}
+
+static void *pes_worker_thread(void *arg)
+{
+    PESWorker *w      = arg;
+    MpegTSContext *ts = w->ts;
+
+    pthread_mutex_lock(&ts->worker_mutex);
+    for (;;) {
+        PESOutput *outputs = NULL, **tail = &outputs;
+        int i, nb_jobs;
+
+        while (!w->abort && !w->nb_jobs)
+            pthread_cond_wait(&w->cond, &ts->worker_mutex);
+        if (w->abort)
+            break;
+
+        /* the reading thread only appends jobs, run all those queued */
+        nb_jobs = w->nb_jobs;
+        pthread_mutex_unlock(&ts->worker_mutex);
+
+        for (i = 0; i < nb_jobs; i++) {
+            PESJob *job = &w->jobs[(w->job_head + i) % MAX_PES_JOBS];
+            PESOutput *o;
+
+            run_pes_job(job);
+            /* errors other than running out of memory only lose the
+             * packet, as in single threaded mode */
+            if (job->ret < 0 && job->ret != AVERROR(ENOMEM)) {
+                av_packet_unref(&job->pkt);
+                continue;
+            }
+            if (!job->stop_parse && job->ret >= 0)
+                continue;
+
+            o = av_mallocz(sizeof(*o));
+            if (!o) {
+                av_packet_unref(&job->pkt);
+                continue;
+            }
+            o->seq = job->seq;
+            o->ret = job->ret;
+            av_init_packet(&o->pkt);
+            av_packet_move_ref(&o->pkt, &job->pkt);
+            *tail = o;
+            tail  = &o->next;
+        }
+
+        pthread_mutex_lock(&ts->worker_mutex);
+        while (outputs) {
+            PESOutput *o = outputs;
+            outputs = o->next;
+            insert_pes_output(ts, o);
+        }
+        w->job_head = (w->job_head + nb_jobs) % MAX_PES_JOBS;
+        w->nb_jobs -= nb_jobs;
+        pthread_cond_signal(&ts->worker_cond);
+    }
+    pthread_mutex_unlock(&ts->worker_mutex);
+
+    return NULL;
+}
+
+static void queue_pes_job(MpegTSContext *ts, MpegTSFilter *tss,
+                          const uint8_t *buf, int buf_size, int is_start,
+                          int64_t pos, int corrupt)
+{
+    PESContext *pes = tss->u.pes_filter.opaque;
+    PESWorker *w    = &ts->workers[tss->pid % ts->nb_workers];
+
+    PESJob *job     = &w->jobs[w->job_tail];
+
+    job->filter   = tss;
+    job->seq      = ts->packet_seq;
+    job->pos      = pos;
+    job->is_start = is_start;
+    job->corrupt  = corrupt;
+    job->discard  = pes_discarded(pes);
+    job->size     = buf_size;
+    memcpy(job->data, buf, buf_size);
+    w->job_tail = (w->job_tail + 1) % MAX_PES_JOBS;
+    pes->threaded = 1;
+
+    if (++w->nb_queued == PES_JOB_BATCH) {
+        pthread_mutex_lock(&ts->worker_mutex);
+        publish_pes_jobs(ts);
+        pthread_mutex_unlock(&ts->worker_mutex);
+    }
+}
+
+static void stop_pes_workers(MpegTSContext *ts)
+{
+    int i;
+
+    if (!ts->workers)
+        return;
+
+    pthread_mutex_lock(&ts->worker_mutex);
+    for (i = 0; i < ts->nb_workers; i++) {
+        ts->workers[i].abort = 1;
+        pthread_cond_signal(&ts->workers[i].cond);
+    }
+    pthread_mutex_unlock(&ts->worker_mutex);
+
+    for (i = 0; i < ts->nb_workers; i++) {
+        pthread_join(ts->workers[i].thread, NULL);
+        pthread_cond_destroy(&ts->workers[i].cond);
+    }
+    pthread_cond_destroy(&ts->worker_cond);
+    pthread_mutex_destroy(&ts->worker_mutex);
+    free_pes_outputs(ts);
+    av_freep(&ts->workers);
+    ts->nb_workers = 0;
+}
+
+static int start_pes_workers(MpegTSContext *ts)
+{
+    int i, ret;
+
+    ts->workers = av_mallocz_array(ts->pes_threads, sizeof(*ts->workers));
+    if (!ts->workers)
+        return AVERROR(ENOMEM);
+    pthread_mutex_init(&ts->worker_mutex, NULL);
+    pthread_cond_init(&ts->worker_cond, NULL);
+
+    for (i = 0; i < ts->pes_threads; i++) {
+        PESWorker *w = &ts->workers[i];
+        w->ts = ts;
+        pthread_cond_init(&w->cond, NULL);
+        ret = pthread_create(&w->thread, NULL, pes_worker_thread, w);
+        if (ret) {
+            pthread_cond_destroy(&w->cond);
+            break;
+        }
+        ts->nb_workers++;
+    }
+    if (!ts->nb_workers) {
+        pthread_cond_destroy(&ts->worker_cond);
+        pthread_mutex_destroy(&ts->worker_mutex);
+        av_freep(&ts->workers);
+        return AVERROR(ret);
+    }
+    return 0;
+}
+#endif
+
 /* handle one TS packet */
 static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
 {
     MpegTSFilter *tss;
     int len, pid, cc, expected_cc, cc_ok, afc, is_start, is_discontinuity,
-        has_adaptation, has_payload;
+        has_adaptation, has_payload, threaded = 0;
     const uint8_t *p, *p_end;
     int64_t pos;
 
@@ -2268,6 +2634,18 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
         return 0;
     ts->current_pid = pid;
 
+#if HAVE_THREADS
+    if (ts->nb_workers && tss->type == MPEGTS_PES) {
+        PESContext *pes = tss->u.pes_filter.opaque;
+        threaded = pes_threadable(ts, tss);
+        /* the PES must not be in use by a worker from now on */
+        if (!threaded && pes->threaded) {
+            wait_for_workers(ts);
+            pes->threaded = 0;
+        }
+    }
+#endif
+
     afc = (packet[3] >> 4) & 3;
     if (afc == 0) /* reserved value */
         return 0;
@@ -2290,7 +2668,7 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
         av_log(ts->stream, AV_LOG_DEBUG,
                "Continuity check failed for pid %d expected %d got %d\n",
                pid, expected_cc, cc);
-        if (tss->type == MPEGTS_PES) {
+        if (tss->type == MPEGTS_PES && !threaded) {
             PESContext *pc = tss->u.pes_filter.opaque;
             pc->flags |= AV_PKT_FLAG_CORRUPT;
         }
@@ -2367,6 +2745,13 @@ static int handle_packet(MpegTSContext *ts, const uint8_t *packet)
     } else {
         int ret;
         // Note: The position here points actually behind the current packet.
+#if HAVE_THREADS
+        if (threaded) {
+            queue_pes_job(ts, tss, p, p_end - p, is_start,
+                          pos - ts->raw_packet_size, !cc_ok);
+            return 0;
+        }
+#endif
         if (tss->type == MPEGTS_PES) {
             if ((ret = tss->u.pes_filter.pes_cb(tss, p, p_end - p, is_start,
                                                 pos - ts->raw_packet_size)) < 0)
@@ -2477,6 +2862,28 @@ static void finished_reading_packet(AVFormatContext *s, int raw_packet_size)
         avio_skip(pb, skip);
 }
 
+static void flush_filters(MpegTSContext *ts)
+{
+    int i;
+
+    av_log(ts->stream, AV_LOG_TRACE, "Skipping after seek\n");
+    /* seek detected, flush pes buffer */
+    for (i = 0; i < NB_PID_MAX; i++) {
+        if (ts->pids[i]) {
+            if (ts->pids[i]->type == MPEGTS_PES) {
+                PESContext *pes = ts->pids[i]->u.pes_filter.opaque;
+                av_buffer_unref(&pes->buffer);
+                pes->data_index = 0;
+                pes->state = MPEGTS_SKIP; /* skip until pes header */
+            } else if (ts->pids[i]->type == MPEGTS_SECTION) {
+                ts->pids[i]->u.section_filter.last_ver = -1;
+            }
+            ts->pids[i]->last_cc = -1;
+            ts->pids[i]->last_pcr = -1;
+        }
+    }
+}
+
 static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
 {
     AVFormatContext *s = ts->stream;
@@ -2485,25 +2892,8 @@ static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
     int64_t packet_num;
     int ret = 0;
 
-    if (avio_tell(s->pb) != ts->last_pos) {
-        int i;
-        av_log(ts->stream, AV_LOG_TRACE, "Skipping after seek\n");
-        /* seek detected, flush pes buffer */
-        for (i = 0; i < NB_PID_MAX; i++) {
-            if (ts->pids[i]) {
-                if (ts->pids[i]->type == MPEGTS_PES) {
-                    PESContext *pes = ts->pids[i]->u.pes_filter.opaque;
-                    av_buffer_unref(&pes->buffer);
-                    pes->data_index = 0;
-                    pes->state = MPEGTS_SKIP; /* skip until pes header */
-                } else if (ts->pids[i]->type == MPEGTS_SECTION) {
-                    ts->pids[i]->u.section_filter.last_ver = -1;
-                }
-                ts->pids[i]->last_cc = -1;
-                ts->pids[i]->last_pcr = -1;
-            }
-        }
-    }
+    if (avio_tell(s->pb) != ts->last_pos)
+        flush_filters(ts);
 
     ts->stop_parse = 0;
     packet_num = 0;
@@ -2530,6 +2920,80 @@ static int handle_packets(MpegTSContext *ts, int64_t nb_packets)
     return ret;
 }
 
+#if HAVE_THREADS
+/**
+ * Like handle_packets(ts, 0), with the PES packets of some streams
+ * assembled by worker threads. Packets are returned in the order in which
+ * they were completed, i.e. the same order as in single threaded mode.
+ * When returning an error, the workers have finished all their jobs and
+ * all packets have been returned.
+ */
+static int handle_packets_threaded(MpegTSContext *ts, AVPacket *pkt)
+{
+    AVFormatContext *s = ts->stream;
+    uint8_t packet[TS_PACKET_SIZE + AV_INPUT_BUFFER_PADDING_SIZE];
+    const uint8_t *data;
+    PESOutput *o = NULL;
+    AVPacket tmp;
+    int64_t nb_packets;
+    int ret;
+
+    if (!ts->workers && (ret = start_pes_workers(ts)) < 0)
+        return ret;
+
+    if (avio_tell(s->pb) != ts->last_pos) {
+        wait_for_workers(ts);
+        free_pes_outputs(ts);
+        flush_filters(ts);
+    }
+
+    memset(packet + TS_PACKET_SIZE, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    for (nb_packets = 0;; nb_packets++) {
+        if (!(nb_packets % PES_JOB_BATCH) && (o = pop_pes_output(ts)))
+            break;
+        ret = read_packet(s, packet, ts->raw_packet_size, &data);
+        if (ret != 0)
+            break;
+
+        /* packets completed on this thread go through the output list too */
+        av_init_packet(&tmp);
+        tmp.data = NULL;
+        tmp.size = 0;
+        ts->pkt        = &tmp;
+        ts->stop_parse = 0;
+        ret = handle_packet(ts, data);
+        ts->pkt        = pkt;
+        finished_reading_packet(s, ts->raw_packet_size);
+        if (ts->stop_parse == 1) {
+            int err = queue_pes_output(ts, &tmp, ts->packet_seq, 0);
+            if (err < 0)
+                ret = err;
+        }
+        ts->packet_seq++;
+        if (ret != 0)
+            break;
+        if (ts->stop_parse > 1) {
+            ret = AVERROR(EAGAIN);
+            break;
+        }
+    }
+    ts->last_pos = avio_tell(s->pb);
+
+    if (!o) {
+        wait_for_workers(ts);
+        if (!(o = pop_pes_output(ts)))
+            return ret;
+    }
+
+    ret = o->ret;
+    if (ret >= 0)
+        av_packet_move_ref(pkt, &o->pkt);
+    av_packet_unref(&o->pkt);
+    av_free(o);
+    return ret;
+}
+#endif
+
 static int mpegts_probe(AVProbeData *p)
 {
     const int size = p->buf_size;
@@ -2772,6 +3236,11 @@ static int mpegts_read_packet(AVFormatContext *s, AVPacket *pkt)
 
     pkt->size = -1;
     ts->pkt = pkt;
+#if HAVE_THREADS
+    if (ts->pes_threads)
+        ret = handle_packets_threaded(ts, pkt);
+    else
+#endif
     ret = handle_packets(ts, 0);
     if (ret < 0) {
         av_packet_unref(ts->pkt);
@@ -2799,6 +3268,9 @@ static void mpegts_free(MpegTSContext *ts)
 {
     int i;
 
+#if HAVE_THREADS
+    stop_pes_workers(ts);
+#endif
     clear_programs(ts);
 
     for (i = 0; i < NB_PID_MAX; i++)
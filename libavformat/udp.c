@@ -26,6 +26,9 @@
 
 #define _DEFAULT_SOURCE
 #define _BSD_SOURCE     /* Needed for using struct ip_mreq with recent glibc */
+#define _GNU_SOURCE     /* Needed for recvmmsg() and sendmmsg() */
+
+#include <time.h>
 
 #include "avformat.h"
 #include "avio_internal.h"
@@ -62,12 +65,25 @@
 
 #if HAVE_PTHREAD_CANCEL
 #include <pthread.h>
+#include <stdatomic.h>
 #endif
 
 #ifndef HAVE_PTHREAD_CANCEL
 #define HAVE_PTHREAD_CANCEL 0
 #endif
 
+#if HAVE_STRUCT_SOCK_TXTIME
+#include <linux/net_tstamp.h>
+#endif
+
+/* SO_TXTIME timestamps use the clock of av_gettime_relative() */
+#if HAVE_PTHREAD_CANCEL && HAVE_SENDMMSG && HAVE_STRUCT_SOCK_TXTIME && \
+    defined(SO_TXTIME) && HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+#define USE_TXTIME 1
+#else
+#define USE_TXTIME 0
+#endif
+
 #ifndef IPV6_ADD_MEMBERSHIP
 #define IPV6_ADD_MEMBERSHIP IPV6_JOIN_GROUP
 #define IPV6_DROP_MEMBERSHIP IPV6_LEAVE_GROUP
@@ -76,6 +92,9 @@
 #define UDP_TX_BUF_SIZE 32768
 #define UDP_MAX_PKT_SIZE 65536
 #define UDP_HEADER_SIZE 8
+#define UDP_RX_BATCH 16
+#define UDP_TX_BATCH 16
+#define UDP_TXTIME_LEAD 2000 /* microseconds */
 
 typedef struct UDPContext {
     const AVClass *class;
@@ -99,12 +118,29 @@ typedef struct UDPContext {
     int circular_buffer_error;
     int64_t bitrate; /* number of bits to send per second */
     int64_t burst_bits;
+    int txtime;
     int close_req;
 #if HAVE_PTHREAD_CANCEL
     pthread_t circular_buffer_thread;
     pthread_mutex_t mutex;
     pthread_cond_t cond;
     int thread_started;
+
+    /* Receive ring of (length, datagram) records, written only by
+     * circular_buffer_task_rx() and read only by udp_read(). The positions
+     * wrap at 2^32 and rx_buf_size is a power of two. The mutex and cond
+     * are only used when udp_read() waits for data. */
+    uint8_t *rx_buf;
+    unsigned rx_buf_size;
+    atomic_uint rx_wpos;
+    atomic_uint rx_rpos;
+    atomic_int rx_waiting;
+#if HAVE_RECVMMSG
+    uint8_t *rx_batch;
+#endif
+#if HAVE_SENDMMSG
+    int no_sendmmsg;
+#endif
 #endif
     uint8_t tmp[UDP_MAX_PKT_SIZE+4];
     int remaining_in_dg;
@@ -122,6 +158,7 @@ static const AVOption options[] = {
     { "buffer_size",    "System data size (in bytes)",                     OFFSET(buffer_size),    AV_OPT_TYPE_INT,    { .i64 = -1 },    -1, INT_MAX, .flags = D|E },
     { "bitrate",        "Bits to send per second",                         OFFSET(bitrate),        AV_OPT_TYPE_INT64,  { .i64 = 0  },     0, INT64_MAX, .flags = E },
     { "burst_bits",     "Max length of bursts in bits (when using bitrate)", OFFSET(burst_bits),   AV_OPT_TYPE_INT64,  { .i64 = 0  },     0, INT64_MAX, .flags = E },
+    { "txtime",         "Let the kernel schedule paced packets with SO_TXTIME (when using bitrate)", OFFSET(txtime), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, .flags = E },
     { "localport",      "Local port",                                      OFFSET(local_port),     AV_OPT_TYPE_INT,    { .i64 = -1 },    -1, INT_MAX, D|E },
     { "local_port",     "Local port",                                      OFFSET(local_port),     AV_OPT_TYPE_INT,    { .i64 = -1 },    -1, INT_MAX, .flags = D|E },
     { "localaddr",      "Local address",                                   OFFSET(localaddr),      AV_OPT_TYPE_STRING, { .str = NULL },               .flags = D|E },
@@ -496,63 +533,227 @@ static int udp_get_file_handle(URLContext *h)
 }
 
 #if HAVE_PTHREAD_CANCEL
+static void rx_ring_write(UDPContext *s, unsigned pos, const uint8_t *src, int len)
+{
+    unsigned off  = pos & (s->rx_buf_size - 1);
+    unsigned len1 = FFMIN(len, s->rx_buf_size - off);
+
+    memcpy(s->rx_buf + off, src, len1);
+    memcpy(s->rx_buf, src + len1, len - len1);
+}
+
+static void rx_ring_read(UDPContext *s, unsigned pos, uint8_t *dst, int len)
+{
+    unsigned off  = pos & (s->rx_buf_size - 1);
+    unsigned len1 = FFMIN(len, s->rx_buf_size - off);
+
+    memcpy(dst, s->rx_buf + off, len1);
+    memcpy(dst + len1, s->rx_buf, len - len1);
+}
+
+/**
+ * Receive up to UDP_RX_BATCH datagrams, waiting for the first one.
+ * @return the number of datagrams, or a negative AVERROR code
+ */
+static int udp_recv_batch(UDPContext *s, uint8_t **data, int *len)
+{
+    int ret;
+
+#if HAVE_RECVMMSG
+    if (s->rx_batch) {
+        struct mmsghdr msgs[UDP_RX_BATCH] = { { { 0 } } };
+        struct iovec iov[UDP_RX_BATCH];
+        int i;
+
+        for (i = 0; i < UDP_RX_BATCH; i++) {
+            iov[i].iov_base = s->rx_batch + i * UDP_MAX_PKT_SIZE;
+            iov[i].iov_len  = UDP_MAX_PKT_SIZE;
+            msgs[i].msg_hdr.msg_iov    = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        ret = recvmmsg(s->udp_fd, msgs, UDP_RX_BATCH, MSG_WAITFORONE, NULL);
+        if (ret >= 0) {
+            for (i = 0; i < ret; i++) {
+                data[i] = iov[i].iov_base;
+                len[i]  = msgs[i].msg_len;
+            }
+            return ret;
+        }
+        if (errno != ENOSYS)
+            return ff_neterrno();
+        /* not supported by the kernel, use recv() from now on */
+        av_freep(&s->rx_batch);
+    }
+#endif
+
+    ret = recv(s->udp_fd, s->tmp, sizeof(s->tmp) - 4, 0);
+    if (ret < 0)
+        return ff_neterrno();
+    data[0] = s->tmp;
+    len[0]  = ret;
+    return 1;
+}
+
 static void *circular_buffer_task_rx( void *_URLContext)
 {
     URLContext *h = _URLContext;
     UDPContext *s = h->priv_data;
-    int old_cancelstate;
+    unsigned wpos = 0;
+    int old_cancelstate, err = 0;
 
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
-    pthread_mutex_lock(&s->mutex);
     if (ff_socket_nonblock(s->udp_fd, 0) < 0) {
         av_log(h, AV_LOG_ERROR, "Failed to set blocking mode");
-        s->circular_buffer_error = AVERROR(EIO);
+        err = AVERROR(EIO);
         goto end;
     }
     while(1) {
-        int len;
+        uint8_t *data[UDP_RX_BATCH];
+        int len[UDP_RX_BATCH];
+        unsigned rpos;
+        int i, nb;
 
-        pthread_mutex_unlock(&s->mutex);
         /* Blocking operations are always cancellation points;
            see "General Information" / "Thread Cancelation Overview"
            in Single Unix. */
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
-        len = recv(s->udp_fd, s->tmp+4, sizeof(s->tmp)-4, 0);
+        nb = udp_recv_batch(s, data, len);
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
-        pthread_mutex_lock(&s->mutex);
-        if (len < 0) {
-            if (ff_neterrno() != AVERROR(EAGAIN) && ff_neterrno() != AVERROR(EINTR)) {
-                s->circular_buffer_error = ff_neterrno();
+        if (nb < 0) {
+            if (nb != AVERROR(EAGAIN) && nb != AVERROR(EINTR)) {
+                err = nb;
                 goto end;
             }
             continue;
         }
-        AV_WL32(s->tmp, len);
 
-        if(av_fifo_space(s->fifo) < len + 4) {
-            /* No Space left */
-            if (s->overrun_nonfatal) {
-                av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
-                        "Surviving due to overrun_nonfatal option\n");
-                continue;
-            } else {
-                av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
-                        "To avoid, increase fifo_size URL option. "
-                        "To survive in such case, use overrun_nonfatal option\n");
-                s->circular_buffer_error = AVERROR(EIO);
-                goto end;
+        rpos = atomic_load_explicit(&s->rx_rpos, memory_order_acquire);
+        for (i = 0; i < nb; i++) {
+            uint8_t hdr[4];
+
+            if (s->rx_buf_size - (wpos - rpos) < len[i] + 4) {
+                /* No Space left */
+                if (s->overrun_nonfatal) {
+                    av_log(h, AV_LOG_WARNING, "Circular buffer overrun. "
+                            "Surviving due to overrun_nonfatal option\n");
+                    continue;
+                } else {
+                    av_log(h, AV_LOG_ERROR, "Circular buffer overrun. "
+                            "To avoid, increase fifo_size URL option. "
+                            "To survive in such case, use overrun_nonfatal option\n");
+                    atomic_store(&s->rx_wpos, wpos);
+                    err = AVERROR(EIO);
+                    goto end;
+                }
             }
+            AV_WL32(hdr, len[i]);
+            rx_ring_write(s, wpos, hdr, 4);
+            rx_ring_write(s, wpos + 4, data[i], len[i]);
+            wpos += len[i] + 4;
+        }
+
+        /* publish the whole batch at once, then wake up the reader if it
+         * went to sleep before seeing it */
+        atomic_store(&s->rx_wpos, wpos);
+        if (atomic_load(&s->rx_waiting)) {
+            pthread_mutex_lock(&s->mutex);
+            pthread_cond_signal(&s->cond);
+            pthread_mutex_unlock(&s->mutex);
         }
-        av_fifo_generic_write(s->fifo, s->tmp, len+4, NULL);
-        pthread_cond_signal(&s->cond);
     }
 
 end:
+    pthread_mutex_lock(&s->mutex);
+    s->circular_buffer_error = err;
     pthread_cond_signal(&s->cond);
     pthread_mutex_unlock(&s->mutex);
     return NULL;
 }
 
+/**
+ * Send datagrams, with their departure times if txtime is enabled.
+ * @return 0 once all of them are sent, or a negative AVERROR code
+ */
+static int udp_send_batch(UDPContext *s, uint8_t **data, const int *len,
+                          const int64_t *txtime, int nb)
+{
+    int i = 0, ret;
+
+#if HAVE_SENDMMSG
+    if (!s->no_sendmmsg) {
+        struct mmsghdr msgs[UDP_TX_BATCH] = { { { 0 } } };
+        struct iovec iov[UDP_TX_BATCH];
+#if USE_TXTIME
+        union {
+            char buf[CMSG_SPACE(sizeof(uint64_t))];
+            struct cmsghdr align;
+        } control[UDP_TX_BATCH];
+#endif
+
+        for (i = 0; i < nb; i++) {
+            struct msghdr *msg = &msgs[i].msg_hdr;
+
+            iov[i].iov_base = data[i];
+            iov[i].iov_len  = len[i];
+            msg->msg_iov    = &iov[i];
+            msg->msg_iovlen = 1;
+            if (!s->is_connected) {
+                msg->msg_name    = &s->dest_addr;
+                msg->msg_namelen = s->dest_addr_len;
+            }
+#if USE_TXTIME
+            if (s->txtime) {
+                struct cmsghdr *cmsg;
+                uint64_t ns = txtime[i] * 1000;
+
+                msg->msg_control    = control[i].buf;
+                msg->msg_controllen = sizeof(control[i].buf);
+                cmsg = CMSG_FIRSTHDR(msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type  = SCM_TXTIME;
+                cmsg->cmsg_len   = CMSG_LEN(sizeof(ns));
+                memcpy(CMSG_DATA(cmsg), &ns, sizeof(ns));
+            }
+#endif
+        }
+
+        i = 0;
+        while (i < nb) {
+            ret = sendmmsg(s->udp_fd, msgs + i, nb - i, 0);
+            if (ret >= 0) {
+                i += ret;
+                continue;
+            }
+            ret = ff_neterrno();
+            if (ret == AVERROR(ENOSYS)) {
+                /* not supported by the kernel, use send() from now on */
+                s->no_sendmmsg = 1;
+                break;
+            }
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR))
+                return ret;
+        }
+    }
+#endif
+
+    while (i < nb) {
+        if (!s->is_connected) {
+            ret = sendto (s->udp_fd, data[i], len[i], 0,
+                        (struct sockaddr *) &s->dest_addr,
+                        s->dest_addr_len);
+        } else
+            ret = send(s->udp_fd, data[i], len[i], 0);
+        if (ret >= 0) {
+            i++;
+        } else {
+            ret = ff_neterrno();
+            if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR))
+                return ret;
+        }
+    }
+    return 0;
+}
+
 static void *circular_buffer_task_tx( void *_URLContext)
 {
     URLContext *h = _URLContext;
@@ -563,6 +764,9 @@ static void *circular_buffer_task_tx( void *_URLContext)
     int64_t sent_bits = 0;
     int64_t burst_interval = s->bitrate ? (s->burst_bits * 1000000 / s->bitrate) : 0;
     int64_t max_delay = s->bitrate ?  ((int64_t)h->max_packet_size * 8 * 1000000 / s->bitrate + 1) : 0;
+    /* with SO_TXTIME, the kernel holds each packet back until its
+     * departure time, so packets can be handed over that much early */
+    int64_t lead = s->txtime ? UDP_TXTIME_LEAD : 0;
 
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
     pthread_mutex_lock(&s->mutex);
@@ -574,75 +778,82 @@ static void *circular_buffer_task_tx( void *_URLContext)
     }
 
     for(;;) {
-        int len;
-        const uint8_t *p;
+        uint8_t *data[UDP_TX_BATCH];
+        int len[UDP_TX_BATCH];
+        int64_t txtime[UDP_TX_BATCH];
         uint8_t tmp[4];
-        int64_t timestamp;
+        int64_t timestamp = 0;
+        int nb, used, ret;
 
-        len=av_fifo_size(s->fifo);
-
-        while (len<4) {
+        while (av_fifo_size(s->fifo) < 4) {
             if (s->close_req)
                 goto end;
             if (pthread_cond_wait(&s->cond, &s->mutex) < 0) {
                 goto end;
             }
-            len=av_fifo_size(s->fifo);
         }
 
-        av_fifo_generic_read(s->fifo, tmp, 4, NULL);
-        len=AV_RL32(tmp);
-
-        av_assert0(len >= 0);
-        av_assert0(len <= sizeof(s->tmp));
-
-        av_fifo_generic_read(s->fifo, s->tmp, len, NULL);
-
-        pthread_mutex_unlock(&s->mutex);
-        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
-
         if (s->bitrate) {
+            pthread_mutex_unlock(&s->mutex);
+            pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
+
             timestamp = av_gettime_relative();
-            if (timestamp < target_timestamp) {
-                int64_t delay = target_timestamp - timestamp;
+            if (timestamp < target_timestamp - lead) {
+                int64_t delay = target_timestamp - lead - timestamp;
                 if (delay > max_delay) {
                     delay = max_delay;
-                    start_timestamp = timestamp + delay;
+                    start_timestamp = timestamp + lead + delay;
+                    target_timestamp = start_timestamp;
                     sent_bits = 0;
                 }
                 av_usleep(delay);
+                timestamp = av_gettime_relative();
             } else {
                 if (timestamp - burst_interval > target_timestamp) {
                     start_timestamp = timestamp - burst_interval;
+                    target_timestamp = start_timestamp;
                     sent_bits = 0;
                 }
             }
-            sent_bits += len * 8;
-            target_timestamp = start_timestamp + sent_bits * 1000000 / s->bitrate;
+
+            pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
+            pthread_mutex_lock(&s->mutex);
         }
 
-        p = s->tmp;
-        while (len) {
-            int ret;
-            av_assert0(len > 0);
-            if (!s->is_connected) {
-                ret = sendto (s->udp_fd, p, len, 0,
-                            (struct sockaddr *) &s->dest_addr,
-                            s->dest_addr_len);
-            } else
-                ret = send(s->udp_fd, p, len, 0);
-            if (ret >= 0) {
-                len -= ret;
-                p   += ret;
-            } else {
-                ret = ff_neterrno();
-                if (ret != AVERROR(EAGAIN) && ret != AVERROR(EINTR)) {
-                    pthread_mutex_lock(&s->mutex);
-                    s->circular_buffer_error = ret;
-                    pthread_mutex_unlock(&s->mutex);
-                    return NULL;
-                }
+        /* Take every queued packet that is due, packed into s->tmp. */
+        nb = used = 0;
+        av_fifo_generic_peek(s->fifo, tmp, 4, NULL);
+        do {
+            av_fifo_drain(s->fifo, 4);
+            len[nb] = AV_RL32(tmp);
+
+            av_assert0(len[nb] >= 0);
+            av_assert0(len[nb] <= sizeof(s->tmp));
+
+            data[nb] = s->tmp + used;
+            av_fifo_generic_read(s->fifo, data[nb], len[nb], NULL);
+            used += len[nb];
+
+            if (s->bitrate) {
+                txtime[nb] = target_timestamp;
+                sent_bits += len[nb] * 8;
+                target_timestamp = start_timestamp + sent_bits * 1000000 / s->bitrate;
             }
+            if (++nb == UDP_TX_BATCH || av_fifo_size(s->fifo) < 4 ||
+                (s->bitrate && target_timestamp > timestamp + lead))
+                break;
+            av_fifo_generic_peek(s->fifo, tmp, 4, NULL);
+        } while (used + AV_RL32(tmp) <= sizeof(s->tmp));
+
+        pthread_mutex_unlock(&s->mutex);
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &old_cancelstate);
+
+        ret = udp_send_batch(s, data, len, txtime, nb);
+        if (ret < 0) {
+            pthread_mutex_lock(&s->mutex);
+            s->circular_buffer_error = ret;
+            pthread_mutex_unlock(&s->mutex);
+            return NULL;
         }
 
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &old_cancelstate);
@@ -773,6 +984,9 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         if (av_find_info_tag(buf, sizeof(buf), "burst_bits", p)) {
             s->burst_bits = strtoll(buf, NULL, 10);
         }
+        if (av_find_info_tag(buf, sizeof(buf), "txtime", p)) {
+            s->txtime = strtol(buf, NULL, 10);
+        }
         if (av_find_info_tag(buf, sizeof(buf), "localaddr", p)) {
             av_strlcpy(localaddr, buf, sizeof(localaddr));
         }
@@ -967,7 +1181,38 @@ static int udp_open(URLContext *h, const char *uri, int flags)
         int ret;
 
         /* start the task going */
-        s->fifo = av_fifo_alloc(s->circular_buffer_size);
+        if (is_output) {
+            s->fifo = av_fifo_alloc(s->circular_buffer_size);
+            if (!s->fifo)
+                goto fail;
+            if (s->txtime) {
+#if USE_TXTIME
+                struct sock_txtime txtime = { .clockid = CLOCK_MONOTONIC };
+                if (setsockopt(udp_fd, SOL_SOCKET, SO_TXTIME, &txtime, sizeof(txtime)) < 0) {
+                    log_net_error(h, AV_LOG_WARNING, "setsockopt(SO_TXTIME)");
+                    s->txtime = 0;
+                }
+#else
+                av_log(h, AV_LOG_WARNING,
+                       "'txtime' option was set but it is not supported "
+                       "on this build\n");
+                s->txtime = 0;
+#endif
+            }
+        } else {
+            s->rx_buf_size = 1U << av_ceil_log2(FFMAX(s->circular_buffer_size,
+                                                      UDP_MAX_PKT_SIZE + 4));
+            s->rx_buf = av_malloc(s->rx_buf_size);
+            if (!s->rx_buf)
+                goto fail;
+            atomic_init(&s->rx_wpos, 0);
+            atomic_init(&s->rx_rpos, 0);
+            atomic_init(&s->rx_waiting, 0);
+#if HAVE_RECVMMSG
+            /* on failure, receive one datagram at a time */
+            s->rx_batch = av_malloc(UDP_RX_BATCH * UDP_MAX_PKT_SIZE);
+#endif
+        }
         ret = pthread_mutex_init(&s->mutex, NULL);
         if (ret != 0) {
             av_log(h, AV_LOG_ERROR, "pthread_mutex_init failed : %s\n", strerror(ret));
@@ -998,6 +1243,12 @@ static int udp_open(URLContext *h, const char *uri, int flags)
     if (udp_fd >= 0)
         closesocket(udp_fd);
     av_fifo_freep(&s->fifo);
+#if HAVE_PTHREAD_CANCEL
+    av_freep(&s->rx_buf);
+#if HAVE_RECVMMSG
+    av_freep(&s->rx_batch);
+#endif
+#endif
     for (i = 0; i < num_include_sources; i++)
         av_freep(&include_sources[i]);
     for (i = 0; i < num_exclude_sources; i++)
@@ -1022,31 +1273,38 @@ static int udp_read(URLContext *h, uint8_t *buf, int size)
 #if HAVE_PTHREAD_CANCEL
     int avail, nonblock = h->flags & AVIO_FLAG_NONBLOCK;
 
-    if (s->fifo) {
-        pthread_mutex_lock(&s->mutex);
+    if (s->rx_buf) {
         do {
-            avail = av_fifo_size(s->fifo);
-            if (avail) { // >=size) {
+            unsigned rpos = atomic_load_explicit(&s->rx_rpos, memory_order_relaxed);
+            unsigned wpos = atomic_load_explicit(&s->rx_wpos, memory_order_acquire);
+
+            if (wpos != rpos) {
                 uint8_t tmp[4];
+                int len;
 
-                av_fifo_generic_read(s->fifo, tmp, 4, NULL);
-                avail= AV_RL32(tmp);
+                rx_ring_read(s, rpos, tmp, 4);
+                avail = len = AV_RL32(tmp);
                 if(avail > size){
                     av_log(h, AV_LOG_WARNING, "Part of datagram lost due to insufficient buffer size\n");
                     avail= size;
                 }
 
-                av_fifo_generic_read(s->fifo, buf, avail, NULL);
-                av_fifo_drain(s->fifo, AV_RL32(tmp) - avail);
-                pthread_mutex_unlock(&s->mutex);
+                rx_ring_read(s, rpos + 4, buf, avail);
+                atomic_store_explicit(&s->rx_rpos, rpos + 4 + len,
+                                      memory_order_release);
                 return avail;
+            }
+
+            pthread_mutex_lock(&s->mutex);
+            /* pairs with the store of rx_wpos and load of rx_waiting in
+             * circular_buffer_task_rx() */
+            atomic_store(&s->rx_waiting, 1);
+            if (atomic_load(&s->rx_wpos) != wpos) {
+                ret = 0;
             } else if(s->circular_buffer_error){
-                int err = s->circular_buffer_error;
-                pthread_mutex_unlock(&s->mutex);
-                return err;
+                ret = s->circular_buffer_error;
             } else if(nonblock) {
-                pthread_mutex_unlock(&s->mutex);
-                return AVERROR(EAGAIN);
+                ret = AVERROR(EAGAIN);
             }
             else {
                 /* FIXME: using the monotonic clock would be better,
@@ -1054,12 +1312,16 @@ static int udp_read(URLContext *h, uint8_t *buf, int size)
                 int64_t t = av_gettime() + 100000;
                 struct timespec tv = { .tv_sec  =  t / 1000000,
                                        .tv_nsec = (t % 1000000) * 1000 };
-                if (pthread_cond_timedwait(&s->cond, &s->mutex, &tv) < 0) {
-                    pthread_mutex_unlock(&s->mutex);
-                    return AVERROR(errno == ETIMEDOUT ? EAGAIN : errno);
-                }
+                if (pthread_cond_timedwait(&s->cond, &s->mutex, &tv) < 0)
+                    ret = AVERROR(errno == ETIMEDOUT ? EAGAIN : errno);
+                else
+                    ret = 0;
                 nonblock = 1;
             }
+            atomic_store(&s->rx_waiting, 0);
+            pthread_mutex_unlock(&s->mutex);
+            if (ret < 0)
+                return ret;
         } while( 1);
     }
 #endif
@@ -1155,6 +1417,12 @@ static int udp_close(URLContext *h)
 #endif
     closesocket(s->udp_fd);
     av_fifo_freep(&s->fifo);
+#if HAVE_PTHREAD_CANCEL
+    av_freep(&s->rx_buf);
+#if HAVE_RECVMMSG
+    av_freep(&s->rx_batch);
+#endif
+#endif
     return 0;
 }
 
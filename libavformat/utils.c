@@ -43,6 +43,7 @@
 #include "audiointerleave.h"
 #include "avformat.h"
 #include "avio_internal.h"
+#include "http.h"
 #include "id3v2.h"
 #include "internal.h"
 #include "metadata.h"
@@ -1986,6 +1987,108 @@ int av_add_index_entry(AVStream *st, int64_t pos, int64_t timestamp,
                               timestamp, size, distance, flags);
 }
 
+static void update_index_entry(AVIndexEntry *ie, const AVIndexEntry *e)
+{
+    int distance = e->min_distance;
+
+    // same rule as ff_add_index_entry(): do not reduce the distance
+    if (ie->pos == e->pos && distance < ie->min_distance)
+        distance = ie->min_distance;
+
+    ie->pos          = e->pos;
+    ie->min_distance = distance;
+    ie->size         = e->size;
+    ie->flags        = e->flags;
+}
+
+static int merge_index_entries(AVStream *st, const AVIndexEntry *entries,
+                               int nb_entries)
+{
+    AVIndexEntry *index;
+    int i, j, w;
+
+    if ((unsigned) st->nb_index_entries + nb_entries >= UINT_MAX / sizeof(AVIndexEntry))
+        return AVERROR(ENOMEM);
+
+    index = av_fast_realloc(st->index_entries,
+                            &st->index_entries_allocated_size,
+                            (st->nb_index_entries + nb_entries) *
+                            sizeof(AVIndexEntry));
+    if (!index)
+        return AVERROR(ENOMEM);
+    st->index_entries = index;
+
+    /* Merge from the back, so that each existing entry moves only once. */
+    i = st->nb_index_entries - 1;
+    j = nb_entries - 1;
+    w = st->nb_index_entries + nb_entries - 1;
+    while (j >= 0) {
+        AVIndexEntry ie;
+        int run, r;
+
+        if (i >= 0 && index[i].timestamp > entries[j].timestamp) {
+            index[w--] = index[i--];
+            continue;
+        }
+
+        /* Apply a run of equal timestamps in order, as successive
+         * ff_add_index_entry() calls would. */
+        for (run = j; run > 0; run--)
+            if (entries[run - 1].timestamp != entries[j].timestamp)
+                break;
+        r = run;
+        if (i >= 0 && index[i].timestamp == entries[j].timestamp)
+            ie = index[i--];
+        else
+            ie = entries[r++];
+        for (; r <= j; r++)
+            update_index_entry(&ie, &entries[r]);
+        j = run - 1;
+        index[w--] = ie;
+    }
+    /* Entries that replaced others left a gap after index[i]. */
+    if (w > i)
+        memmove(index + i + 1, index + w + 1,
+                (st->nb_index_entries + nb_entries - 1 - w) * sizeof(AVIndexEntry));
+    st->nb_index_entries += nb_entries - (w - i);
+
+    return 0;
+}
+
+int ff_add_index_entries(AVStream *st, AVIndexEntry *entries, int nb_entries)
+{
+    int i, ret, nb_sorted = 0;
+
+    for (i = 0; i < nb_entries; i++) {
+        AVIndexEntry *e = &entries[i];
+        int64_t timestamp;
+
+        if (e->timestamp == AV_NOPTS_VALUE || e->size < 0)
+            continue;
+
+        timestamp = wrap_timestamp(st, e->timestamp);
+        if (is_relative(timestamp))
+            timestamp -= RELATIVE_TS_BASE;
+
+        if (nb_sorted && entries[nb_sorted - 1].timestamp > timestamp)
+            break;
+
+        entries[nb_sorted]             = *e;
+        entries[nb_sorted++].timestamp = timestamp;
+    }
+
+    if (nb_sorted && (ret = merge_index_entries(st, entries, nb_sorted)) < 0)
+        return ret;
+
+    /* Unsorted input, insert the remaining entries one by one. */
+    for (; i < nb_entries; i++)
+        av_add_index_entry(st, entries[i].pos, entries[i].timestamp,
+                           entries[i].size, entries[i].min_distance,
+                           entries[i].flags);
+
+    return 0;
+}
+
 int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
                               int64_t wanted_timestamp, int flags)
 {
@@ -2029,7 +2132,18 @@ int ff_index_search_timestamp(const AVIndexEntry *entries, int nb_entries,
     return m;
 }
 
+static AVIndexEntry *get_index_entry(AVStream *st, int i)
+{
+    return i < st->nb_index_entries ? &st->index_entries[i] : NULL;
+}
+
 void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
+{
+    ff_configure_buffers_for_entries(s, time_tolerance, get_index_entry);
+}
+
+void ff_configure_buffers_for_entries(AVFormatContext *s, int64_t time_tolerance,
+                                      AVIndexEntry *(*get_entry)(AVStream *st, int i))
 {
     int ist1, ist2;
     int64_t pos_delta = 0;
@@ -2051,18 +2165,17 @@ void ff_configure_buffers_for_index(AVFormatContext *s, int64_t time_tolerance)
         AVStream *st1 = s->streams[ist1];
         for (ist2 = 0; ist2 < s->nb_streams; ist2++) {
             AVStream *st2 = s->streams[ist2];
+            AVIndexEntry *e1, *e2;
             int i1, i2;
 
             if (ist1 == ist2)
                 continue;
 
-            for (i1 = i2 = 0; i1 < st1->nb_index_entries; i1++) {
-                AVIndexEntry *e1 = &st1->index_entries[i1];
+            for (i1 = i2 = 0; (e1 = get_entry(st1, i1)); i1++) {
                 int64_t e1_pts = av_rescale_q(e1->timestamp, st1->time_base, AV_TIME_BASE_Q);
 
                 skip = FFMAX(skip, e1->size);
-                for (; i2 < st2->nb_index_entries; i2++) {
-                    AVIndexEntry *e2 = &st2->index_entries[i2];
+                for (; (e2 = get_entry(st2, i2)); i2++) {
                     int64_t e2_pts = av_rescale_q(e2->timestamp, st2->time_base, AV_TIME_BASE_Q);
                     if (e2_pts - e1_pts < time_tolerance)
                         continue;
@@ -4863,6 +4976,9 @@ int avformat_network_init(void)
 int avformat_network_deinit(void)
 {
 #if CONFIG_NETWORK
+#if CONFIG_HTTP_PROTOCOL
+    ff_http_pool_close();
+#endif
     ff_network_close();
     ff_tls_deinit();
     ff_network_inited_globally = 0;
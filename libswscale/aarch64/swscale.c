@@ -29,16 +29,78 @@ void ff_yuv2planeX_8_neon(const int16_t *filter, int filterSize,
                           const int16_t **src, uint8_t *dest, int dstW,
                           const uint8_t *dither, int offset);
 
+void ff_yuv2plane1_8_neon(const int16_t *src, uint8_t *dest, int dstW,
+                          const uint8_t *dither, int offset);
+
+void ff_yuv2nv12cX_neon_asm(int isSwapped, const uint8_t *chrDither,
+                            const int16_t *chrFilter, int chrFilterSize,
+                            const int16_t **chrUSrc, const int16_t **chrVSrc,
+                            uint8_t *dest, int chrDstW);
+
+static void yuv2nv12cX_neon(SwsContext *c, const int16_t *chrFilter, int chrFilterSize,
+                            const int16_t **chrUSrc, const int16_t **chrVSrc,
+                            uint8_t *dest, int chrDstW)
+{
+    ff_yuv2nv12cX_neon_asm(c->dstFormat == AV_PIX_FMT_NV21, c->chrDither8,
+                           chrFilter, chrFilterSize, chrUSrc, chrVSrc,
+                           dest, chrDstW);
+}
+
+#define INPUT_FUNCS(fmt)                                                    \
+void ff_##fmt##ToY_neon(uint8_t *dst, const uint8_t *src,                   \
+                        const uint8_t *unused1, const uint8_t *unused2,     \
+                        int width, uint32_t *rgb2yuv);                      \
+void ff_##fmt##ToUV_neon(uint8_t *dstU, uint8_t *dstV,                      \
+                         const uint8_t *unused0, const uint8_t *src1,       \
+                         const uint8_t *src2, int width, uint32_t *rgb2yuv);\
+void ff_##fmt##ToUV_half_neon(uint8_t *dstU, uint8_t *dstV,                 \
+                              const uint8_t *unused0, const uint8_t *src1,  \
+                              const uint8_t *src2, int width,               \
+                              uint32_t *rgb2yuv);
+
+INPUT_FUNCS(rgb24)
+INPUT_FUNCS(bgr24)
+INPUT_FUNCS(rgba)
+INPUT_FUNCS(bgra)
+INPUT_FUNCS(argb)
+INPUT_FUNCS(abgr)
+
+#define case_rgb(x, X)                                                      \
+    case AV_PIX_FMT_ ## X:                                                  \
+        c->lumToYV12 = ff_ ## x ## ToY_neon;                                \
+        if (c->chrSrcHSubSample)                                            \
+            c->chrToYV12 = ff_ ## x ## ToUV_half_neon;                      \
+        else                                                                \
+            c->chrToYV12 = ff_ ## x ## ToUV_neon;                           \
+        break
+
 av_cold void ff_sws_init_swscale_aarch64(SwsContext *c)
 {
     int cpu_flags = av_get_cpu_flags();
 
     if (have_neon(cpu_flags)) {
         if (c->srcBpc == 8 && c->dstBpc <= 14) {
-            c->hyScale = c->hcScale = ff_hscale_8_to_15_neon;
+            /* The filters are processed 8 taps at a time */
+            if (!(c->hLumFilterSize & 7))
+                c->hyScale = ff_hscale_8_to_15_neon;
+            if (!(c->hChrFilterSize & 7))
+                c->hcScale = ff_hscale_8_to_15_neon;
         }
         if (c->dstBpc == 8) {
             c->yuv2planeX = ff_yuv2planeX_8_neon;
+            c->yuv2plane1 = ff_yuv2plane1_8_neon;
+            if (c->dstFormat == AV_PIX_FMT_NV12 || c->dstFormat == AV_PIX_FMT_NV21)
+                c->yuv2nv12cX = yuv2nv12cX_neon;
+        }
+        switch (c->srcFormat) {
+        case_rgb(rgb24, RGB24);
+        case_rgb(bgr24, BGR24);
+        case_rgb(rgba,  RGBA);
+        case_rgb(bgra,  BGRA);
+        case_rgb(argb,  ARGB);
+        case_rgb(abgr,  ABGR);
+        default:
+            break;
         }
     }
 }
@@ -95,6 +95,41 @@ DECLARE_FF_NVX_TO_RGBX_FUNCS(nvx, bgra)
 DECLARE_FF_NVX_TO_ALL_RGBX_FUNCS(nv12)
 DECLARE_FF_NVX_TO_ALL_RGBX_FUNCS(nv21)
 
+void ff_planar10_to_p010_y_neon(uint16_t *dst, int dstStride,
+                                const uint16_t *src, int srcStride,
+                                int width, int height);
+void ff_planar10_to_p010_uv_neon(uint16_t *dst, int dstStride,
+                                 const uint16_t *srcU, int srcUStride,
+                                 const uint16_t *srcV, int srcVStride,
+                                 int width, int height);
+void ff_planar8_to_p010_y_neon(uint16_t *dst, int dstStride,
+                               const uint8_t *src, int srcStride,
+                               int width, int height);
+void ff_planar8_to_p010_uv_neon(uint16_t *dst, int dstStride,
+                                const uint8_t *srcU, int srcUStride,
+                                const uint8_t *srcV, int srcVStride,
+                                int width, int height);
+
+#define DECLARE_FF_PLANARX_TO_P010_FUNCS(bits, type)                                        \
+static int planar##bits##_to_p010_neon_wrapper(SwsContext *c, const uint8_t *src[],         \
+                                               int srcStride[], int srcSliceY,              \
+                                               int srcSliceH, uint8_t *dst[],               \
+                                               int dstStride[]) {                           \
+    ff_planar##bits##_to_p010_y_neon((uint16_t *)(dst[0] + dstStride[0] * srcSliceY),       \
+                                     dstStride[0],                                          \
+                                     (const type *)src[0], srcStride[0],                    \
+                                     c->srcW, srcSliceH);                                   \
+    ff_planar##bits##_to_p010_uv_neon((uint16_t *)(dst[1] + dstStride[1] * srcSliceY / 2),  \
+                                      dstStride[1],                                         \
+                                      (const type *)src[1], srcStride[1],                   \
+                                      (const type *)src[2], srcStride[2],                   \
+                                      c->srcW / 2, (srcSliceH + 1) / 2);                    \
+    return srcSliceH;                                                                       \
+}                                                                                           \
+
+DECLARE_FF_PLANARX_TO_P010_FUNCS(10, uint16_t)
+DECLARE_FF_PLANARX_TO_P010_FUNCS(8,  uint8_t)
+
 /* We need a 16 pixel width alignment. This constraint can easily be removed
  * for input reading but for the output which is 4-bytes per pixel (RGBA) the
  * assembly might be writing as much as 4*15=60 extra bytes at the end of the
@@ -122,6 +157,13 @@ static void get_unscaled_swscale_neon(SwsContext *c) {
     SET_FF_NVX_TO_ALL_RGBX_FUNC(nv21, NV21, accurate_rnd);
     SET_FF_NVX_TO_ALL_RGBX_FUNC(yuv420p, YUV420P, accurate_rnd);
     SET_FF_NVX_TO_ALL_RGBX_FUNC(yuv422p, YUV422P, accurate_rnd);
+
+    if ((c->srcFormat == AV_PIX_FMT_YUV420P10 || c->srcFormat == AV_PIX_FMT_YUVA420P10) &&
+        c->dstFormat == AV_PIX_FMT_P010)
+        c->swscale = planar10_to_p010_neon_wrapper;
+    if ((c->srcFormat == AV_PIX_FMT_YUV420P || c->srcFormat == AV_PIX_FMT_YUVA420P) &&
+        c->dstFormat == AV_PIX_FMT_P010LE)
+        c->swscale = planar8_to_p010_neon_wrapper;
 }
 
 void ff_get_unscaled_swscale_aarch64(SwsContext *c)
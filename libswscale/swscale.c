@@ -228,9 +228,15 @@ static void lumRangeFromJpeg16_c(int16_t *_dst, int width)
     if (DEBUG_SWSCALE_BUFFERS)                  \
         av_log(c, AV_LOG_DEBUG, __VA_ARGS__)
 
-static int swscale(SwsContext *c, const uint8_t *src[],
-                   int srcStride[], int srcSliceY,
-                   int srcSliceH, uint8_t *dst[], int dstStride[])
+/**
+ * Scale a slice of the source into the destination. When the slice starts
+ * the frame, output begins at line dstSliceY instead of 0; no more than
+ * dstSliceH lines are output from there.
+ */
+static int swscale_lines(SwsContext *c, const uint8_t *src[],
+                         int srcStride[], int srcSliceY,
+                         int srcSliceH, uint8_t *dst[], int dstStride[],
+                         int dstSliceY, int dstSliceH)
 {
     /* load a few things into local vars to make the code more readable?
      * and faster */
@@ -256,6 +262,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     const int chrSrcSliceH           = AV_CEIL_RSHIFT(srcSliceH,   c->chrSrcVSubSample);
     int should_dither                = isNBPS(c->srcFormat) ||
                                        is16BPS(c->srcFormat);
+    const int dstEnd                 = dstSliceY + dstSliceH;
     int lastDstY;
 
     /* vars which will change and which we need to store back in the context */
@@ -337,7 +344,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     if (srcSliceY == 0) {
         lumBufIndex  = -1;
         chrBufIndex  = -1;
-        dstY         = 0;
+        dstY         = dstSliceY;
         lastInLumBuf = -1;
         lastInChrBuf = -1;
     }
@@ -369,7 +376,7 @@ static int swscale(SwsContext *c, const uint8_t *src[],
         hout_slice->width = dstW;
     }
 
-    for (; dstY < dstH; dstY++) {
+    for (; dstY < dstEnd; dstY++) {
         const int chrDstY = dstY >> c->chrDstVSubSample;
         int use_mmx_vfilter= c->use_mmx_vfilter;
 
@@ -531,6 +538,68 @@ static int swscale(SwsContext *c, const uint8_t *src[],
     return dstY - lastDstY;
 }
 
+static int swscale(SwsContext *c, const uint8_t *src[],
+                   int srcStride[], int srcSliceY,
+                   int srcSliceH, uint8_t *dst[], int dstStride[])
+{
+    return swscale_lines(c, src, srcStride, srcSliceY, srcSliceH,
+                         dst, dstStride, 0, c->dstH);
+}
+
+typedef struct SwsBandArgs {
+    const uint8_t **src;
+    const int *srcStride;
+    uint8_t **dst;
+    const int *dstStride;
+} SwsBandArgs;
+
+/**
+ * Scale one band of destination lines from the whole source frame, using
+ * the slice context of the job. Bands are aligned on the chroma subsampling
+ * so that every chroma line belongs to a single band.
+ */
+static int scale_band(SwsContext *c, void *arg, int jobnr, int nb_jobs)
+{
+    const SwsBandArgs *args = arg;
+    const int align = 1 << c->chrDstVSubSample;
+    const int rows  = c->dstH / align;
+    int start       = rows *  jobnr      / nb_jobs * align;
+    int end         = rows * (jobnr + 1) / nb_jobs * align;
+    const uint8_t *src[4];
+    uint8_t *dst[4];
+    int srcStride[4], dstStride[4];
+
+    if (jobnr == nb_jobs - 1)
+        end = c->dstH;
+
+    memcpy(src,       args->src,       sizeof(src));
+    memcpy(srcStride, args->srcStride, sizeof(srcStride));
+    memcpy(dst,       args->dst,       sizeof(dst));
+    memcpy(dstStride, args->dstStride, sizeof(dstStride));
+
+    return swscale_lines(c->slice_ctx[jobnr], src, srcStride, 0, c->srcH,
+                         dst, dstStride, start, end - start);
+}
+
+static int swscale_threaded(SwsContext *c, const uint8_t *src[],
+                            int srcStride[], uint8_t *dst[], int dstStride[])
+{
+    SwsBandArgs args = { src, srcStride, dst, dstStride };
+    int i;
+
+    if (usePal(c->srcFormat)) {
+        for (i = 0; i < c->nb_slice_ctx; i++) {
+            memcpy(c->slice_ctx[i]->pal_yuv, c->pal_yuv, sizeof(c->pal_yuv));
+            memcpy(c->slice_ctx[i]->pal_rgb, c->pal_rgb, sizeof(c->pal_rgb));
+        }
+    }
+
+    ff_sws_thread_execute(c, scale_band, &args, NULL, c->nb_slice_ctx);
+
+    c->dstY = c->dstH;
+    return c->dstH;
+}
+
 av_cold void ff_sws_init_range_convert(SwsContext *c)
 {
     c->lumConvertRange = NULL;
@@ -977,7 +1046,11 @@ int attribute_align_arg sws_scale(struct SwsContext *c,
     /* reset slice direction at end of frame */
     if (srcSliceY_internal + srcSliceH == c->srcH)
         c->sliceDir = 0;
-    ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
+    /* complete frames are split into bands of lines scaled concurrently */
+    if (c->nb_slice_ctx && srcSliceY_internal == 0 && srcSliceH == c->srcH)
+        ret = swscale_threaded(c, src2, srcStride2, dst2, dstStride2);
+    else
+        ret = c->swscale(c, src2, srcStride2, srcSliceY_internal, srcSliceH, dst2, dstStride2);
 
 
     if (c->dstXYZ && !(c->srcXYZ && c->srcW==c->dstW && c->srcH==c->dstH)) {
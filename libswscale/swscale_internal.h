@@ -321,6 +321,14 @@ typedef struct SwsContext {
     uint8_t *cascaded1_tmp[4];
     int cascaded_mainindex;
 
+    /* The slice_ctx fields allow splitting the output of a frame into bands
+     * of lines, which are scaled concurrently by one context per band.
+     */
+    int nb_threads;               ///< Number of threads requested by the user, 0 for automatic.
+    struct SwsContext **slice_ctx;
+    int nb_slice_ctx;
+    struct SwsThreadContext *thread;
+
     double gamma_value;
     int gamma_flag;
     int is_internal_gamma;
@@ -830,6 +838,25 @@ void ff_get_unscaled_swscale_aarch64(SwsContext *c);
  */
 SwsFunc ff_getSwsFunc(SwsContext *c);
 
+typedef int (sws_thread_func)(SwsContext *c, void *arg, int jobnr, int nb_jobs);
+
+/**
+ * Start a pool of nb_threads worker threads for c.
+ *
+ * @return the number of threads started, 1 if threading is unavailable,
+ *         or a negative error code
+ */
+int ff_sws_thread_init(SwsContext *c, int nb_threads);
+
+/**
+ * Run func on the worker threads for jobs 0 to nb_jobs - 1 and wait for all
+ * of them to complete. If ret is not NULL, it receives the return values.
+ */
+void ff_sws_thread_execute(SwsContext *c, sws_thread_func *func,
+                           void *arg, int *ret, int nb_jobs);
+
+void ff_sws_thread_free(SwsContext *c);
+
 void ff_sws_init_input_funcs(SwsContext *c);
 void ff_sws_init_output_funcs(SwsContext *c,
                               yuv2planar1_fn *yuv2plane1,
@@ -850,6 +850,7 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     const AVPixFmtDescriptor *desc_dst;
     const AVPixFmtDescriptor *desc_src;
     int need_reinit = 0;
+    int i;
 
     handle_formats(c);
     desc_dst = av_pix_fmt_desc_get(c->dstFormat);
@@ -889,6 +890,13 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     c->dstFormatBpp = av_get_bits_per_pixel(desc_dst);
     c->srcFormatBpp = av_get_bits_per_pixel(desc_src);
 
+    for (i = 0; i < c->nb_slice_ctx; i++) {
+        int ret = sws_setColorspaceDetails(c->slice_ctx[i], inv_table, srcRange,
+                                           table, dstRange, brightness, contrast, saturation);
+        if (ret < 0)
+            return ret;
+    }
+
     if (c->cascaded_context[c->cascaded_mainindex])
         return sws_setColorspaceDetails(c->cascaded_context[c->cascaded_mainindex],inv_table, srcRange,table, dstRange, brightness,  contrast, saturation);
 
@@ -1146,6 +1154,89 @@ static enum AVPixelFormat alphaless_fmt(enum AVPixelFormat fmt)
     }
 }
 
+#if !HAVE_THREADS
+int ff_sws_thread_init(SwsContext *c, int nb_threads)
+{
+    return 1;
+}
+
+void ff_sws_thread_execute(SwsContext *c, sws_thread_func *func,
+                           void *arg, int *ret, int nb_jobs)
+{
+}
+
+void ff_sws_thread_free(SwsContext *c)
+{
+}
+#endif
+
+static av_cold void free_slice_contexts(SwsContext *c)
+{
+    int i;
+
+    ff_sws_thread_free(c);
+    for (i = 0; i < c->nb_slice_ctx; i++)
+        sws_freeContext(c->slice_ctx[i]);
+    av_freep(&c->slice_ctx);
+    c->nb_slice_ctx = 0;
+}
+
+/**
+ * Create one context per thread, each scaling its own band of the
+ * destination with private line buffers.
+ */
+static av_cold int init_slice_contexts(SwsContext *c, SwsFilter *srcFilter,
+                                       SwsFilter *dstFilter)
+{
+    int i, ret, nb_threads = c->nb_threads;
+
+    /* error diffusion carries state from one line to the next */
+    if (c->dither == SWS_DITHER_ED)
+        return 0;
+
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+    /* every band contains at least one chroma line */
+    nb_threads = FFMIN(nb_threads, c->dstH >> c->chrDstVSubSample);
+    if (nb_threads <= 1)
+        return 0;
+
+    c->slice_ctx = av_mallocz_array(nb_threads, sizeof(*c->slice_ctx));
+    if (!c->slice_ctx)
+        return AVERROR(ENOMEM);
+
+    for (i = 0; i < nb_threads; i++) {
+        SwsContext *s = sws_alloc_context();
+        if (!s)
+            return AVERROR(ENOMEM);
+        c->slice_ctx[c->nb_slice_ctx++] = s;
+
+        ret = av_opt_copy(s, c);
+        if (ret < 0)
+            return ret;
+        s->nb_threads = 1;
+
+        ret = sws_init_context(s, srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
+        ret = sws_setColorspaceDetails(s, c->srcColorspaceTable, c->srcRange,
+                                       c->dstColorspaceTable, c->dstRange,
+                                       c->brightness, c->contrast, c->saturation);
+        if (ret < 0)
+            return ret;
+    }
+
+    ret = ff_sws_thread_init(c, nb_threads);
+    if (ret < 0)
+        return ret;
+    if (ret <= 1)
+        free_slice_contexts(c);
+    else
+        av_log(c, AV_LOG_VERBOSE, "using %d threads\n", nb_threads);
+
+    return 0;
+}
+
 av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
                              SwsFilter *dstFilter)
 {
@@ -1794,7 +1885,10 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     }
 
     c->swscale = ff_getSwsFunc(c);
-    return ff_init_filters(c);
+    ret = ff_init_filters(c);
+    if (ret < 0)
+        return ret;
+    return init_slice_contexts(c, srcFilter, dstFilter);
 fail: // FIXME replace things by appropriate error codes
     if (ret == RETCODE_USE_CASCADE)  {
         int tmpW = sqrt(srcW * (int64_t)dstW);
@@ -2279,6 +2373,8 @@ void sws_freeContext(SwsContext *c)
     if (!c)
         return;
 
+    free_slice_contexts(c);
+
     for (i = 0; i < 4; i++)
         av_freep(&c->dither_error[i]);
 
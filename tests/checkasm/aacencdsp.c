@@ -0,0 +1,107 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+#include "checkasm.h"
+#include "libavcodec/aacencdsp.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+
+#define BUF_SIZE 1024
+
+#define randomize_float(buf, len)                               \
+    do {                                                        \
+        int i;                                                  \
+        for (i = 0; i < len; i++) {                             \
+            float f = (float)rnd() / (UINT_MAX >> 5) - 16.0f;   \
+            buf[i] = f;                                         \
+        }                                                       \
+    } while (0)
+
+/* Band sizes are multiples of 4 but not always of 8, so also test an odd
+ * number of 4-coefficient groups. */
+static int random_size(void)
+{
+    return ((rnd() % (BUF_SIZE / 4)) + 1) * 4;
+}
+
+static void test_abs_pow34(void)
+{
+    LOCAL_ALIGNED_16(float, in,   [BUF_SIZE]);
+    LOCAL_ALIGNED_16(float, out,  [BUF_SIZE]);
+    LOCAL_ALIGNED_16(float, out2, [BUF_SIZE]);
+    AACEncDSPContext s;
+
+    declare_func(void, float *, const float *, int);
+
+    ff_aacenc_dsp_init(&s);
+
+    if (check_func(s.abs_pow34, "abs_pow34")) {
+        int size = random_size();
+        randomize_float(in, BUF_SIZE);
+        call_ref(out,  in, size);
+        call_new(out2, in, size);
+        if (memcmp(out, out2, size * sizeof(*out)))
+            fail();
+        bench_new(out, in, BUF_SIZE);
+    }
+
+    report("abs_pow34");
+}
+
+static void test_quant_bands(void)
+{
+    static const int maxvals[] = { 1, 2, 4, 7, 12, 16, 8191 };
+    LOCAL_ALIGNED_16(float, in,     [BUF_SIZE]);
+    LOCAL_ALIGNED_16(float, scaled, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(int,   out,    [BUF_SIZE]);
+    LOCAL_ALIGNED_16(int,   out2,   [BUF_SIZE]);
+    const float rounding = (rnd() & 1) ? 0.1054f : 0.4054f;
+    const float Q34 = (float)rnd() / UINT_MAX * 8.0f;
+    AACEncDSPContext s;
+    int i, sign;
+
+    declare_func(void, int *, const float *, const float *, int, int, int,
+                 const float, const float);
+
+    ff_aacenc_dsp_init(&s);
+
+    randomize_float(in, BUF_SIZE);
+    for (i = 0; i < BUF_SIZE; i++)
+        scaled[i] = fabsf(in[i]);
+
+    for (sign = 0; sign <= 1; sign++) {
+        if (check_func(s.quant_bands, "quant_bands_%s", sign ? "signed" : "unsigned")) {
+            int size   = random_size();
+            int maxval = maxvals[rnd() % FF_ARRAY_ELEMS(maxvals)];
+            call_ref(out,  in, scaled, size, sign, maxval, Q34, rounding);
+            call_new(out2, in, scaled, size, sign, maxval, Q34, rounding);
+            if (memcmp(out, out2, size * sizeof(*out)))
+                fail();
+            bench_new(out, in, scaled, BUF_SIZE, sign, maxval, Q34, rounding);
+        }
+    }
+
+    report("quant_bands");
+}
+
+void checkasm_check_aacencdsp(void)
+{
+    test_abs_pow34();
+    test_quant_bands();
+}
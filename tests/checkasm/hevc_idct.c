@@ -59,6 +59,34 @@ static void check_idct(HEVCDSPContext h, int bit_depth)
     }
 }
 
+static void check_idct_col_limit(HEVCDSPContext h, int bit_depth)
+{
+    int i, j;
+    LOCAL_ALIGNED(32, int16_t, coeffs0, [32 * 32]);
+    LOCAL_ALIGNED(32, int16_t, coeffs1, [32 * 32]);
+
+    for (i = 3; i <= 5; i++) {
+        int block_size = 1 << i;
+        int size = block_size * block_size;
+        /* only the top left 4x4 coefficients are coded, which the
+         * decoder signals with the smallest col_limit */
+        int col_limit = 4;
+        declare_func(void, int16_t *coeffs, int col_limit);
+
+        memset(coeffs0, 0, sizeof(*coeffs0) * size);
+        for (j = 0; j < 4; j++)
+            randomize_buffers(coeffs0 + j * block_size, 4);
+        memcpy(coeffs1, coeffs0, sizeof(*coeffs0) * size);
+        if (check_func(h.idct[i - 2], "hevc_idct_%dx%d_col4_%d", block_size, block_size, bit_depth)) {
+            call_ref(coeffs0, col_limit);
+            call_new(coeffs1, col_limit);
+            if (memcmp(coeffs0, coeffs1, sizeof(*coeffs0) * size))
+                fail();
+            bench_new(coeffs1, col_limit);
+        }
+    }
+}
+
 static void check_idct_dc(HEVCDSPContext h, int bit_depth)
 {
     int i;
@@ -102,4 +130,12 @@ void checkasm_check_hevc_idct(void)
         check_idct(h, bit_depth);
     }
     report("idct");
+
+    for (bit_depth = 8; bit_depth <= 10; bit_depth++) {
+        HEVCDSPContext h;
+
+        ff_hevc_dsp_init(&h, bit_depth);
+        check_idct_col_limit(h, bit_depth);
+    }
+    report("idct_col_limit");
 }
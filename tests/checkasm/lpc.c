@@ -0,0 +1,115 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <math.h>
+#include "checkasm.h"
+#include "libavcodec/lpc.h"
+#include "libavcodec/mathops.h"
+#include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "libavutil/mem.h"
+
+#define BUF_SIZE 4608
+#define MAX_ORDER 32
+
+/* The SIMD versions sum in a different order, compare relative to the
+ * energy of the signal. */
+static int autocorr_near(const double *a, const double *b, int lag)
+{
+    int i;
+
+    for (i = 0; i <= lag; i++)
+        if (!double_near_abs_eps(a[i], b[i], fabs(a[0]) * 1e-12 + 1e-6))
+            return 0;
+    return 1;
+}
+
+static void test_apply_welch_window(LPCContext *s, const int32_t *samples)
+{
+    double *ref = s->windowed_samples;
+    double *new = ref + BUF_SIZE + 2;
+    int i, len, n;
+
+    declare_func(void, const int32_t *, int, double *);
+
+    if (check_func(s->lpc_apply_welch_window, "apply_welch_window")) {
+        /* one random length for each len % 4, the SIMD versions handle
+         * the center differently depending on it */
+        for (n = 0; n < 4; n++) {
+            len = (rnd() % (BUF_SIZE / 4 - 1) + 1) * 4 + n - 2;
+            call_ref(samples, len, ref);
+            call_new(samples, len, new);
+            for (i = 0; i < len; i++) {
+                /* the center of odd lengths is not written */
+                if ((len & 1) && i == len >> 1)
+                    continue;
+                if (!double_near_abs_eps(ref[i], new[i], fabs(ref[i]) * 1e-9 + 1e-3))
+                    break;
+            }
+            if (i < len)
+                fail();
+        }
+        bench_new(samples, BUF_SIZE, new);
+    }
+
+    report("apply_welch_window");
+}
+
+static void test_compute_autocorr(LPCContext *s, const int32_t *samples)
+{
+    double ref[MAX_ORDER + 1], new[MAX_ORDER + 1];
+    int lag, len;
+
+    declare_func(void, const double *, int, int, double *);
+
+    for (lag = 1; lag <= MAX_ORDER; lag++) {
+        if (check_func(s->lpc_compute_autocorr, "compute_autocorr_%d", lag)) {
+            len = (rnd() % (BUF_SIZE - MAX_ORDER)) + MAX_ORDER;
+            s->lpc_apply_welch_window(samples, len, s->windowed_samples);
+            /* the samples past len are zero in all callers */
+            s->windowed_samples[len] = s->windowed_samples[len + 1] = 0.0;
+            call_ref(s->windowed_samples, len, lag, ref);
+            call_new(s->windowed_samples, len, lag, new);
+            if (!autocorr_near(ref, new, lag))
+                fail();
+            bench_new(s->windowed_samples, BUF_SIZE, lag, new);
+        }
+    }
+
+    report("compute_autocorr");
+}
+
+void checkasm_check_lpc(void)
+{
+    LOCAL_ALIGNED_16(int32_t, samples, [BUF_SIZE]);
+    LPCContext s;
+    int i;
+
+    /* room for the reference output and a second output for the welch
+     * window test behind the windowed samples */
+    if (ff_lpc_init(&s, 2 * BUF_SIZE + 2, MAX_ORDER, FF_LPC_TYPE_LEVINSON) < 0)
+        return;
+
+    for (i = 0; i < BUF_SIZE; i++)
+        samples[i] = sign_extend(rnd(), 24);
+
+    test_apply_welch_window(&s, samples);
+    test_compute_autocorr(&s, samples);
+
+    ff_lpc_end(&s);
+}
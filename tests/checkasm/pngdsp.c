@@ -0,0 +1,101 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mem.h"
+
+#include "libavcodec/pngdsp.h"
+
+#include "checkasm.h"
+
+#define BUF_SIZE 4096
+
+#define randomize_buffers(buf, size)     \
+    do {                                 \
+        int j;                           \
+        for (j = 0; j < size; j++)       \
+            buf[j] = rnd() & 0xFF;       \
+    } while (0)
+
+static void check_add_bytes_l2(PNGDSPContext *c)
+{
+    LOCAL_ALIGNED_16(uint8_t, src1, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, src2, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [BUF_SIZE]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [BUF_SIZE]);
+    int w = av_clip(rnd() % BUF_SIZE, 1, BUF_SIZE);
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *dst, uint8_t *src1,
+                      uint8_t *src2, int w);
+
+    if (check_func(c->add_bytes_l2, "add_bytes_l2")) {
+        randomize_buffers(src1, BUF_SIZE);
+        randomize_buffers(src2, BUF_SIZE);
+        call_ref(dst0, src1, src2, w);
+        call_new(dst1, src1, src2, w);
+        if (memcmp(dst0, dst1, w))
+            fail();
+        bench_new(dst1, src1, src2, BUF_SIZE);
+    }
+    report("add_bytes_l2");
+}
+
+static void check_add_paeth_prediction(PNGDSPContext *c)
+{
+    /* room for the previous pixel in front and an overwrite at the end */
+    LOCAL_ALIGNED_16(uint8_t, src,  [BUF_SIZE + 16]);
+    LOCAL_ALIGNED_16(uint8_t, top,  [BUF_SIZE + 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst0, [BUF_SIZE + 16]);
+    LOCAL_ALIGNED_16(uint8_t, dst1, [BUF_SIZE + 16]);
+    static const int bpps[] = { 3, 4, 6, 8 };
+    int i;
+    declare_func_emms(AV_CPU_FLAG_MMX, void, uint8_t *dst, uint8_t *src,
+                      uint8_t *top, int w, int bpp);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(bpps); i++) {
+        int bpp = bpps[i];
+        int w   = bpp * av_clip(rnd() % (BUF_SIZE / bpp), 2, BUF_SIZE / bpp - 1);
+        /* as in png_filter_row(), the last 3 bytes are redone in C when
+         * the pixel size is not a multiple of 4 */
+        int cmp = (bpp & 3) ? w - 3 : w;
+
+        if (check_func(c->add_paeth_prediction, "add_paeth_prediction_%d", bpp)) {
+            randomize_buffers(src, BUF_SIZE + 16);
+            randomize_buffers(top, BUF_SIZE + 16);
+            randomize_buffers(dst0, BUF_SIZE + 16);
+            memcpy(dst1, dst0, BUF_SIZE + 16);
+            call_ref(dst0 + 8, src + 8, top + 8, w, bpp);
+            call_new(dst1 + 8, src + 8, top + 8, w, bpp);
+            if (memcmp(dst0, dst1, 8 + cmp))
+                fail();
+            bench_new(dst1 + 8, src + 8, top + 8, w, bpp);
+        }
+    }
+    report("add_paeth_prediction");
+}
+
+void checkasm_check_pngdsp(void)
+{
+    PNGDSPContext c;
+
+    ff_pngdsp_init(&c);
+
+    check_add_bytes_l2(&c);
+    check_add_paeth_prediction(&c);
+}
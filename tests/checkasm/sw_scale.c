@@ -0,0 +1,653 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/log.h"
+#include "libavutil/mem.h"
+#include "libavutil/pixdesc.h"
+
+#include "libswscale/rgb2rgb.h"
+#include "libswscale/swscale.h"
+#include "libswscale/swscale_internal.h"
+
+#include "checkasm.h"
+
+#define MAX_WIDTH  128
+#define MAX_HEIGHT 4
+/* Line strides, leaving room for functions working on whole vectors */
+#define SRC_STRIDE (MAX_WIDTH * 4 + 64)
+#define DST_STRIDE (MAX_WIDTH * 2 + 32)
+
+/* Largest differences allowed against the exact C code, for the
+ * implementations computing with less precision */
+#define YUV2YUVX_MAX_DIFF 2
+#define YUV2RGB_MAX_DIFF  3
+
+static const int widths[] = { 1, 7, 8, 15, 16, 17, 33, 64, MAX_WIDTH - 1, MAX_WIDTH };
+
+#define randomize_buffer(buf, size)                                         \
+    do {                                                                    \
+        int j;                                                              \
+        for (j = 0; j < (size); j += 4)                                     \
+            AV_WN32(&(buf)[j], rnd());                                      \
+    } while (0)
+
+static int cmp_off_by_n(const uint8_t *a, const uint8_t *b, int size, int max_diff)
+{
+    int i;
+    for (i = 0; i < size; i++)
+        if (abs(a[i] - b[i]) > max_diff)
+            return 1;
+    return 0;
+}
+
+static SwsContext *get_context(enum AVPixelFormat src_fmt,
+                               enum AVPixelFormat dst_fmt, int flags)
+{
+    /* Use a different destination size so that no unscaled converter is picked */
+    return sws_getContext(MAX_WIDTH, 16, src_fmt, MAX_WIDTH / 2, 8, dst_fmt,
+                          SWS_BILINEAR | flags, NULL, NULL, NULL);
+}
+
+#define HSCALE_SRC_SIZE 512
+#define HSCALE_DST_WIDTH 64
+#define MAX_HFILTER_TAPS 40
+
+static void check_hscale(void)
+{
+    static const int filter_sizes[] = { 4, 8, 12, 16, 32, MAX_HFILTER_TAPS };
+    LOCAL_ALIGNED_32(uint8_t, src, [HSCALE_SRC_SIZE + MAX_HFILTER_TAPS]);
+    LOCAL_ALIGNED_32(int16_t, filter, [HSCALE_DST_WIDTH * MAX_HFILTER_TAPS]);
+    LOCAL_ALIGNED_32(int32_t, filter_pos, [HSCALE_DST_WIDTH]);
+    LOCAL_ALIGNED_32(int32_t, dst0, [HSCALE_DST_WIDTH]);
+    LOCAL_ALIGNED_32(int32_t, dst1, [HSCALE_DST_WIDTH]);
+    SwsContext *c = get_context(AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, 0);
+    int i, j, k, to19;
+
+    declare_func(void, SwsContext *c, int16_t *dst, int dstW, const uint8_t *src,
+                 const int16_t *filter, const int32_t *filterPos, int filterSize);
+
+    if (!c) {
+        fail();
+        return;
+    }
+
+    for (to19 = 0; to19 < 2; to19++) {
+        for (i = 0; i < FF_ARRAY_ELEMS(filter_sizes); i++) {
+            int size = filter_sizes[i];
+            /* Keep the sums within range, so that no clipping differences
+             * show up between implementations */
+            int max_coeff = (1 << 14) / size;
+
+            c->srcBpc = 8;
+            c->dstBpc = to19 ? 16 : 8;
+            c->hLumFilterSize = c->hChrFilterSize = size;
+            ff_getSwsFunc(c);
+
+            if (check_func(c->hyScale, "hscale_8_to_%d_%dtap", to19 ? 19 : 15, size)) {
+                randomize_buffer(src, HSCALE_SRC_SIZE + MAX_HFILTER_TAPS);
+                for (j = 0; j < HSCALE_DST_WIDTH; j++) {
+                    filter_pos[j] = rnd() % (HSCALE_SRC_SIZE - size);
+                    for (k = 0; k < size; k++)
+                        filter[j * size + k] = (int)(rnd() % (2 * max_coeff + 1)) - max_coeff;
+                }
+                memset(dst0, 0xAA, sizeof(*dst0) * HSCALE_DST_WIDTH);
+                memset(dst1, 0xAA, sizeof(*dst1) * HSCALE_DST_WIDTH);
+                call_ref(c, (int16_t *)dst0, HSCALE_DST_WIDTH, src, filter, filter_pos, size);
+                call_new(c, (int16_t *)dst1, HSCALE_DST_WIDTH, src, filter, filter_pos, size);
+                if (memcmp(dst0, dst1, sizeof(*dst0) * HSCALE_DST_WIDTH))
+                    fail();
+                bench_new(c, (int16_t *)dst1, HSCALE_DST_WIDTH, src, filter, filter_pos, size);
+            }
+        }
+    }
+    sws_freeContext(c);
+    report("hscale");
+}
+
+static void check_input_rgb(void)
+{
+    static const enum AVPixelFormat formats[] = {
+        AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24,
+        AV_PIX_FMT_RGBA,  AV_PIX_FMT_BGRA,
+        AV_PIX_FMT_ARGB,  AV_PIX_FMT_ABGR,
+    };
+    LOCAL_ALIGNED_32(uint8_t, src, [SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_u, [DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_v, [DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_u, [DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_v, [DST_STRIDE]);
+    int i, n, half;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++) {
+        const char *name = av_get_pix_fmt_name(formats[i]);
+
+        for (half = 0; half < 2; half++) {
+            SwsContext *c = get_context(formats[i], AV_PIX_FMT_YUV420P,
+                                        half ? 0 : SWS_FULL_CHR_H_INP);
+            uint32_t *tab;
+
+            if (!c) {
+                fail();
+                return;
+            }
+            tab = (uint32_t *)c->input_rgb2yuv_table;
+
+            if (!half) {
+                declare_func(void, uint8_t *dst, const uint8_t *src,
+                             const uint8_t *unused1, const uint8_t *unused2,
+                             int width, uint32_t *rgb2yuv);
+
+                if (check_func(c->lumToYV12, "%sToY", name)) {
+                    for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+                        int w = widths[n];
+                        randomize_buffer(src, SRC_STRIDE);
+                        memset(dst0_u, 0xAA, DST_STRIDE);
+                        memset(dst1_u, 0xAA, DST_STRIDE);
+                        call_ref(dst0_u, src, NULL, NULL, w, tab);
+                        call_new(dst1_u, src, NULL, NULL, w, tab);
+                        if (memcmp(dst0_u, dst1_u, DST_STRIDE))
+                            fail();
+                    }
+                    bench_new(dst1_u, src, NULL, NULL, MAX_WIDTH, tab);
+                }
+            }
+
+            {
+                declare_func(void, uint8_t *dstU, uint8_t *dstV,
+                             const uint8_t *unused0, const uint8_t *src1,
+                             const uint8_t *src2, int width, uint32_t *rgb2yuv);
+
+                if (check_func(c->chrToYV12, "%sToUV%s", name, half ? "_half" : "")) {
+                    for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+                        int w = half ? (widths[n] + 1) >> 1 : widths[n];
+                        randomize_buffer(src, SRC_STRIDE);
+                        memset(dst0_u, 0xAA, DST_STRIDE);
+                        memset(dst0_v, 0xAA, DST_STRIDE);
+                        memset(dst1_u, 0xAA, DST_STRIDE);
+                        memset(dst1_v, 0xAA, DST_STRIDE);
+                        call_ref(dst0_u, dst0_v, NULL, src, src, w, tab);
+                        call_new(dst1_u, dst1_v, NULL, src, src, w, tab);
+                        if (memcmp(dst0_u, dst1_u, DST_STRIDE) ||
+                            memcmp(dst0_v, dst1_v, DST_STRIDE))
+                            fail();
+                    }
+                    bench_new(dst1_u, dst1_v, NULL, src, src,
+                              half ? MAX_WIDTH / 2 : MAX_WIDTH, tab);
+                }
+            }
+
+            sws_freeContext(c);
+        }
+    }
+    report("input_rgb");
+}
+
+#define MAX_VFILTER_TAPS 16
+#define VSRC_STRIDE (MAX_WIDTH + 16)
+
+/* Random vertical filter of size taps; the coefficients are bounded so that
+ * the 32-bit sums of 15-bit input samples cannot overflow */
+static void random_vfilter(int16_t *filter, int size)
+{
+    int k;
+    for (k = 0; k < size; k++)
+        filter[k] = ((int)(rnd() % 8192) - 2048) * 8 / size;
+}
+
+static void check_yuv2planeX(void)
+{
+    static const int filter_sizes[] = { 2, 4, 8, MAX_VFILTER_TAPS };
+    LOCAL_ALIGNED_32(int16_t, src, [MAX_VFILTER_TAPS * VSRC_STRIDE]);
+    LOCAL_ALIGNED_32(int16_t, filter, [MAX_VFILTER_TAPS]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_WIDTH + 16]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_WIDTH + 16]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+    const int16_t *lines[MAX_VFILTER_TAPS];
+    /* The approximate MMX vertical scaler is only avoided with accurate rounding */
+    SwsContext *c = get_context(AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, SWS_ACCURATE_RND);
+    int i, j, n, offset;
+
+    declare_func(void, const int16_t *filter, int filterSize, const int16_t **src,
+                 uint8_t *dest, int dstW, const uint8_t *dither, int offset);
+
+    if (!c) {
+        fail();
+        return;
+    }
+
+    for (j = 0; j < MAX_VFILTER_TAPS; j++)
+        lines[j] = src + j * VSRC_STRIDE;
+
+    if (check_func(c->yuv2planeX, "yuv2planeX_8")) {
+        for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+            for (i = 0; i < FF_ARRAY_ELEMS(filter_sizes); i++) {
+                for (offset = 0; offset <= 3; offset += 3) {
+                    int k, w = widths[n], size = filter_sizes[i];
+                    for (k = 0; k < MAX_VFILTER_TAPS * VSRC_STRIDE; k++)
+                        src[k] = rnd() & 0x7FFF;
+                    random_vfilter(filter, size);
+                    randomize_buffer(dither, 8);
+                    memset(dst0, 0xAA, MAX_WIDTH + 16);
+                    memset(dst1, 0xAA, MAX_WIDTH + 16);
+                    call_ref(filter, size, lines, dst0, w, dither, offset);
+                    call_new(filter, size, lines, dst1, w, dither, offset);
+                    /* Some implementations write whole vectors past the width */
+                    if (memcmp(dst0, dst1, w))
+                        fail();
+                }
+            }
+        }
+        bench_new(filter, 8, lines, dst1, MAX_WIDTH, dither, 0);
+    }
+    sws_freeContext(c);
+    report("yuv2planeX");
+}
+
+static void check_yuv2plane1(void)
+{
+    LOCAL_ALIGNED_32(int16_t, src, [MAX_WIDTH + 16]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_WIDTH + 16]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_WIDTH + 16]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+    SwsContext *c = get_context(AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, 0);
+    int n, offset;
+
+    declare_func(void, const int16_t *src, uint8_t *dest, int dstW,
+                 const uint8_t *dither, int offset);
+
+    if (!c) {
+        fail();
+        return;
+    }
+
+    if (check_func(c->yuv2plane1, "yuv2plane1_8")) {
+        for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+            for (offset = 0; offset <= 3; offset += 3) {
+                int w = widths[n];
+                randomize_buffer((uint8_t *)src, sizeof(*src) * (MAX_WIDTH + 16));
+                randomize_buffer(dither, 8);
+                memset(dst0, 0xAA, MAX_WIDTH + 16);
+                memset(dst1, 0xAA, MAX_WIDTH + 16);
+                call_ref(src, dst0, w, dither, offset);
+                call_new(src, dst1, w, dither, offset);
+                if (memcmp(dst0, dst1, MAX_WIDTH + 16))
+                    fail();
+            }
+        }
+        bench_new(src, dst1, MAX_WIDTH, dither, 0);
+    }
+    sws_freeContext(c);
+    report("yuv2plane1");
+}
+
+/* Plain C version of the 8-bit vertical scaler, used as the reference for
+ * the implementations taking the packed MMX filter layout */
+static void ref_yuv2planeX_8(const int16_t *filter, int filterSize,
+                             const int16_t **src, uint8_t *dest, int dstW,
+                             const uint8_t *dither)
+{
+    int i, j;
+    for (i = 0; i < dstW; i++) {
+        int val = dither[i & 7] << 12;
+        for (j = 0; j < filterSize; j++)
+            val += src[j][i] * filter[j];
+        dest[i] = av_clip_uint8(val >> 19);
+    }
+}
+
+static void check_yuv2yuvX(void)
+{
+    static const int filter_sizes[] = { 1, 2, 3, 4, 8, MAX_VFILTER_TAPS };
+    LOCAL_ALIGNED_32(int16_t, src, [MAX_VFILTER_TAPS * VSRC_STRIDE]);
+    LOCAL_ALIGNED_32(int16_t, filter, [MAX_VFILTER_TAPS]);
+    /* Source pointer followed by the coefficient replicated 4 times,
+     * 16 bytes per tap, terminated by a NULL pointer */
+    LOCAL_ALIGNED_16(int32_t, mmx_filter, [4 * (MAX_VFILTER_TAPS + 1)]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_WIDTH + 16]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_WIDTH + 16]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+    const int16_t *lines[MAX_VFILTER_TAPS];
+    SwsContext *c = get_context(AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P, 0);
+    int i, j, n;
+
+    declare_func(void, const int16_t *filter, int filterSize, const int16_t **src,
+                 uint8_t *dest, int dstW, const uint8_t *dither, int offset);
+
+    if (!c) {
+        fail();
+        return;
+    }
+
+    for (j = 0; j < MAX_VFILTER_TAPS; j++)
+        lines[j] = src + j * VSRC_STRIDE;
+
+    /* Only implementations using the packed filter layout are covered here,
+     * the others are checked by yuv2planeX */
+    if (c->use_mmx_vfilter && check_func(c->yuv2planeX, "yuv2yuvX")) {
+        for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+            for (i = 0; i < FF_ARRAY_ELEMS(filter_sizes); i++) {
+                int k, w = widths[n], size = filter_sizes[i];
+                for (k = 0; k < MAX_VFILTER_TAPS * VSRC_STRIDE; k++)
+                    src[k] = rnd() & 0x7FFF;
+                random_vfilter(filter, size);
+                memset(mmx_filter, 0, sizeof(*mmx_filter) * 4 * (MAX_VFILTER_TAPS + 1));
+                for (k = 0; k < size; k++) {
+                    *(const void **)&mmx_filter[4 * k] = lines[k];
+                    mmx_filter[4 * k + 2] =
+                    mmx_filter[4 * k + 3] = (uint16_t)filter[k] * 0x10001U;
+                }
+                randomize_buffer(dither, 8);
+                memset(dst0, 0xAA, MAX_WIDTH + 16);
+                memset(dst1, 0xAA, MAX_WIDTH + 16);
+                ref_yuv2planeX_8(filter, size, lines, dst0, w, dither);
+                call_new((const int16_t *)mmx_filter, size, lines, dst1, w, dither, 0);
+                /* The coefficients are applied with 16-bit multiplies,
+                 * truncating every product */
+                if (cmp_off_by_n(dst0, dst1, w, YUV2YUVX_MAX_DIFF))
+                    fail();
+            }
+        }
+        bench_new((const int16_t *)mmx_filter, MAX_VFILTER_TAPS, lines, dst1, MAX_WIDTH, dither, 0);
+    }
+    sws_freeContext(c);
+    report("yuv2yuvX");
+}
+
+static void check_yuv2nv12cX(void)
+{
+    static const enum AVPixelFormat formats[] = { AV_PIX_FMT_NV12, AV_PIX_FMT_NV21 };
+    static const int filter_sizes[] = { 1, 2, 3, 4, 8 };
+    LOCAL_ALIGNED_32(int16_t, src_u, [MAX_VFILTER_TAPS * (MAX_WIDTH + 16)]);
+    LOCAL_ALIGNED_32(int16_t, src_v, [MAX_VFILTER_TAPS * (MAX_WIDTH + 16)]);
+    LOCAL_ALIGNED_32(int16_t, filter, [MAX_VFILTER_TAPS]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [2 * MAX_WIDTH + 32]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [2 * MAX_WIDTH + 32]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+    const int16_t *u[MAX_VFILTER_TAPS], *v[MAX_VFILTER_TAPS];
+    int i, j, n;
+
+    declare_func(void, SwsContext *c, const int16_t *chrFilter, int chrFilterSize,
+                 const int16_t **chrUSrc, const int16_t **chrVSrc,
+                 uint8_t *dest, int chrDstW);
+
+    for (j = 0; j < MAX_VFILTER_TAPS; j++) {
+        u[j] = src_u + j * (MAX_WIDTH + 16);
+        v[j] = src_v + j * (MAX_WIDTH + 16);
+    }
+
+    for (i = 0; i < FF_ARRAY_ELEMS(formats); i++) {
+        SwsContext *c = get_context(AV_PIX_FMT_YUV420P, formats[i], 0);
+
+        if (!c) {
+            fail();
+            return;
+        }
+        c->chrDither8 = dither;
+
+        if (check_func(c->yuv2nv12cX, "yuv2%scX", av_get_pix_fmt_name(formats[i]))) {
+            for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+                for (j = 0; j < FF_ARRAY_ELEMS(filter_sizes); j++) {
+                    int k, w = widths[n], size = filter_sizes[j];
+                    /* Keep the vertical source within the 15-bit range
+                     * produced by the horizontal scaler */
+                    for (k = 0; k < MAX_VFILTER_TAPS * (MAX_WIDTH + 16); k++) {
+                        src_u[k] = rnd() & 0x7FFF;
+                        src_v[k] = rnd() & 0x7FFF;
+                    }
+                    for (k = 0; k < MAX_VFILTER_TAPS; k++)
+                        filter[k] = (int)(rnd() % 8192) - 2048;
+                    randomize_buffer(dither, 8);
+                    memset(dst0, 0xAA, 2 * MAX_WIDTH + 32);
+                    memset(dst1, 0xAA, 2 * MAX_WIDTH + 32);
+                    call_ref(c, filter, size, u, v, dst0, w);
+                    call_new(c, filter, size, u, v, dst1, w);
+                    if (memcmp(dst0, dst1, 2 * MAX_WIDTH + 32))
+                        fail();
+                }
+            }
+            bench_new(c, filter, 4, u, v, dst1, MAX_WIDTH);
+        }
+        sws_freeContext(c);
+    }
+    report("yuv2nv12cX");
+}
+
+/* The C 4:2:2 converters double the chroma strides in place, so they
+ * have to be reset before every call */
+static void set_yuv2rgb_strides(int *stride)
+{
+    stride[0] = stride[1] = stride[2] = SRC_STRIDE;
+    stride[3] = 0;
+}
+
+static void check_yuv2rgb(void)
+{
+    static const enum AVPixelFormat src_formats[] = {
+        AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P,
+    };
+    static const enum AVPixelFormat dst_formats[] = {
+        AV_PIX_FMT_RGBA,  AV_PIX_FMT_BGRA,
+        AV_PIX_FMT_ARGB,  AV_PIX_FMT_ABGR,
+        AV_PIX_FMT_RGB24, AV_PIX_FMT_BGR24,
+    };
+    LOCAL_ALIGNED_32(uint8_t, src_y, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src_u, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src_v, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [MAX_HEIGHT * SRC_STRIDE]);
+    const uint8_t *src[4] = { src_y, src_u, src_v, NULL };
+    uint8_t *dst0_planes[4] = { dst0, NULL, NULL, NULL };
+    uint8_t *dst1_planes[4] = { dst1, NULL, NULL, NULL };
+    int src_stride[4], dst_stride[4] = { SRC_STRIDE, 0, 0, 0 };
+    int log_level = av_log_get_level();
+    int i, j, y;
+
+    declare_func(int, SwsContext *c, const uint8_t *src[], int srcStride[],
+                 int srcSliceY, int srcSliceH, uint8_t *dst[], int dstStride[]);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(src_formats); i++) {
+        for (j = 0; j < FF_ARRAY_ELEMS(dst_formats); j++) {
+            int line_size = MAX_WIDTH * av_get_padded_bits_per_pixel(av_pix_fmt_desc_get(dst_formats[j])) / 8;
+            SwsContext *c;
+
+            /* Same size and no accurate rounding, for the table based
+             * unscaled converters to be picked. Do not warn about the
+             * conversions that have no SIMD version. */
+            av_log_set_level(AV_LOG_ERROR);
+            c = sws_getContext(MAX_WIDTH, MAX_HEIGHT, src_formats[i],
+                               MAX_WIDTH, MAX_HEIGHT, dst_formats[j],
+                               SWS_BILINEAR, NULL, NULL, NULL);
+            av_log_set_level(log_level);
+
+            if (!c) {
+                fail();
+                return;
+            }
+
+            if (check_func(c->swscale, "yuv2rgb_%s_to_%s",
+                           av_get_pix_fmt_name(src_formats[i]),
+                           av_get_pix_fmt_name(dst_formats[j]))) {
+                randomize_buffer(src_y, MAX_HEIGHT * SRC_STRIDE);
+                randomize_buffer(src_u, MAX_HEIGHT * SRC_STRIDE);
+                randomize_buffer(src_v, MAX_HEIGHT * SRC_STRIDE);
+                /* The C 4:2:2 code only reads the chroma of the even lines */
+                for (y = 0; y < MAX_HEIGHT; y += 2) {
+                    memcpy(src_u + (y + 1) * SRC_STRIDE, src_u + y * SRC_STRIDE, SRC_STRIDE);
+                    memcpy(src_v + (y + 1) * SRC_STRIDE, src_v + y * SRC_STRIDE, SRC_STRIDE);
+                }
+                memset(dst0, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+                memset(dst1, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+                set_yuv2rgb_strides(src_stride);
+                call_ref(c, src, src_stride, 0, MAX_HEIGHT, dst0_planes, dst_stride);
+                set_yuv2rgb_strides(src_stride);
+                call_new(c, src, src_stride, 0, MAX_HEIGHT, dst1_planes, dst_stride);
+                /* The SIMD versions work at a lower precision than the tables */
+                for (y = 0; y < MAX_HEIGHT; y++)
+                    if (cmp_off_by_n(dst0 + y * SRC_STRIDE, dst1 + y * SRC_STRIDE,
+                                     line_size, YUV2RGB_MAX_DIFF))
+                        fail();
+                /* Not for 4:2:2, which would grow the strides at every run */
+                if (src_formats[i] == AV_PIX_FMT_YUV420P) {
+                    set_yuv2rgb_strides(src_stride);
+                    bench_new(c, src, src_stride, 0, MAX_HEIGHT, dst1_planes, dst_stride);
+                }
+            }
+            sws_freeContext(c);
+        }
+    }
+    report("yuv2rgb");
+}
+
+static void check_interleave_bytes(void)
+{
+    LOCAL_ALIGNED_32(uint8_t, src0, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, src1, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_u, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_v, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_u, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_v, [MAX_HEIGHT * SRC_STRIDE]);
+    int n;
+
+    if (check_func(interleaveBytes, "interleave_bytes")) {
+        declare_func(void, const uint8_t *src1, const uint8_t *src2, uint8_t *dest,
+                     int width, int height, int src1Stride,
+                     int src2Stride, int dstStride);
+
+        for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+            int w = widths[n];
+            randomize_buffer(src0, MAX_HEIGHT * SRC_STRIDE);
+            randomize_buffer(src1, MAX_HEIGHT * SRC_STRIDE);
+            memset(dst0_u, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+            memset(dst1_u, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+            call_ref(src0, src1, dst0_u, w, MAX_HEIGHT,
+                     SRC_STRIDE / 2, SRC_STRIDE / 4, SRC_STRIDE);
+            call_new(src0, src1, dst1_u, w, MAX_HEIGHT,
+                     SRC_STRIDE / 2, SRC_STRIDE / 4, SRC_STRIDE);
+            if (memcmp(dst0_u, dst1_u, MAX_HEIGHT * SRC_STRIDE))
+                fail();
+        }
+        bench_new(src0, src1, dst1_u, MAX_WIDTH, MAX_HEIGHT,
+                  SRC_STRIDE / 2, SRC_STRIDE / 4, SRC_STRIDE);
+    }
+
+    if (check_func(deinterleaveBytes, "deinterleave_bytes")) {
+        declare_func(void, const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                     int width, int height, int srcStride,
+                     int dst1Stride, int dst2Stride);
+
+        for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+            int w = widths[n];
+            randomize_buffer(src0, MAX_HEIGHT * SRC_STRIDE);
+            memset(dst0_u, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+            memset(dst0_v, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+            memset(dst1_u, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+            memset(dst1_v, 0xAA, MAX_HEIGHT * SRC_STRIDE);
+            call_ref(src0, dst0_u, dst0_v, w, MAX_HEIGHT,
+                     SRC_STRIDE, SRC_STRIDE / 2, SRC_STRIDE / 4);
+            call_new(src0, dst1_u, dst1_v, w, MAX_HEIGHT,
+                     SRC_STRIDE, SRC_STRIDE / 2, SRC_STRIDE / 4);
+            if (memcmp(dst0_u, dst1_u, MAX_HEIGHT * SRC_STRIDE) ||
+                memcmp(dst0_v, dst1_v, MAX_HEIGHT * SRC_STRIDE))
+                fail();
+        }
+        bench_new(src0, dst1_u, dst1_v, MAX_WIDTH, MAX_HEIGHT,
+                  SRC_STRIDE, SRC_STRIDE / 2, SRC_STRIDE / 4);
+    }
+
+    report("interleave_bytes");
+}
+
+static void check_packed422_to_planar(void)
+{
+    static const struct {
+        const char *name;
+        int is_420;
+    } funcs[] = {
+        { "yuyvtoyuv420", 1 }, { "yuyvtoyuv422", 0 },
+        { "uyvytoyuv420", 1 }, { "uyvytoyuv422", 0 },
+    };
+    void (*const *func_ptrs[])(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                               const uint8_t *src, int width, int height,
+                               int lumStride, int chromStride, int srcStride) = {
+        &yuyvtoyuv420, &yuyvtoyuv422, &uyvytoyuv420, &uyvytoyuv422,
+    };
+    LOCAL_ALIGNED_32(uint8_t, src, [MAX_HEIGHT * SRC_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_y, [MAX_HEIGHT * DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_u, [MAX_HEIGHT * DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst0_v, [MAX_HEIGHT * DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_y, [MAX_HEIGHT * DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_u, [MAX_HEIGHT * DST_STRIDE]);
+    LOCAL_ALIGNED_32(uint8_t, dst1_v, [MAX_HEIGHT * DST_STRIDE]);
+    int i, n;
+
+    declare_func(void, uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
+                 const uint8_t *src, int width, int height,
+                 int lumStride, int chromStride, int srcStride);
+
+    for (i = 0; i < FF_ARRAY_ELEMS(funcs); i++) {
+        if (check_func(*func_ptrs[i], "%s", funcs[i].name)) {
+            /* The x86 4:2:0 versions average the chroma of two lines with
+             * pavgb, which rounds instead of truncating like the C code */
+            int max_diff = ARCH_X86 && funcs[i].is_420 &&
+                           (av_get_cpu_flags() & AV_CPU_FLAG_MMXEXT);
+
+            for (n = 0; n < FF_ARRAY_ELEMS(widths); n++) {
+                int w = widths[n];
+                randomize_buffer(src, MAX_HEIGHT * SRC_STRIDE);
+                memset(dst0_y, 0xAA, MAX_HEIGHT * DST_STRIDE);
+                memset(dst0_u, 0xAA, MAX_HEIGHT * DST_STRIDE);
+                memset(dst0_v, 0xAA, MAX_HEIGHT * DST_STRIDE);
+                memset(dst1_y, 0xAA, MAX_HEIGHT * DST_STRIDE);
+                memset(dst1_u, 0xAA, MAX_HEIGHT * DST_STRIDE);
+                memset(dst1_v, 0xAA, MAX_HEIGHT * DST_STRIDE);
+                call_ref(dst0_y, dst0_u, dst0_v, src, w, MAX_HEIGHT,
+                         DST_STRIDE, DST_STRIDE / 2, SRC_STRIDE);
+                call_new(dst1_y, dst1_u, dst1_v, src, w, MAX_HEIGHT,
+                         DST_STRIDE, DST_STRIDE / 2, SRC_STRIDE);
+                if (memcmp(dst0_y, dst1_y, MAX_HEIGHT * DST_STRIDE) ||
+                    cmp_off_by_n(dst0_u, dst1_u, MAX_HEIGHT * DST_STRIDE, max_diff) ||
+                    cmp_off_by_n(dst0_v, dst1_v, MAX_HEIGHT * DST_STRIDE, max_diff))
+                    fail();
+            }
+            bench_new(dst1_y, dst1_u, dst1_v, src, MAX_WIDTH, MAX_HEIGHT,
+                      DST_STRIDE, DST_STRIDE / 2, SRC_STRIDE);
+        }
+    }
+    report("packed422_to_planar");
+}
+
+void checkasm_check_sw_scale(void)
+{
+    check_hscale();
+    check_input_rgb();
+    check_yuv2planeX();
+    check_yuv2plane1();
+    check_yuv2yuvX();
+    check_yuv2nv12cX();
+    check_yuv2rgb();
+
+    ff_sws_rgb2rgb_init();
+    check_interleave_bytes();
+    check_packed422_to_planar();
+}
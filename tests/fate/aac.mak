@@ -237,6 +237,14 @@ fate-aac-pred-encode: CMP_TARGET = 841
 fate-aac-pred-encode: FUZZ = 12
 fate-aac-pred-encode: SIZE_TOLERANCE = 3560
 
+# The channel elements are coded in parallel with slice threads, the output
+# must not depend on the number of threads.
+FATE_AAC_THREADS = fate-aac-main-5.1-threads-1 fate-aac-main-5.1-threads-4
+$(FATE_AAC_THREADS): tests/data/asynth-44100-2.wav
+$(FATE_AAC_THREADS): SRC = $(TARGET_PATH)/tests/data/asynth-44100-2.wav
+$(FATE_AAC_THREADS): REF = $(SRC_PATH)/tests/ref/fate/aac-main-5.1-threads
+fate-aac-main-5.1-threads-%: CMD = framecrc -i $(SRC) -af "pan=5.1|c0=c0|c1=c1|c2=0.5*c0+0.5*c1|c3=0.3*c0-0.2*c1|c4=c0-c1|c5=0.7*c1" -c:a aac -profile:a aac_main -b:a 512k -thread_type slice -threads $(@:fate-aac-main-5.1-threads-%=%)
+
 FATE_AAC_LATM += fate-aac-latm_000000001180bc60
 fate-aac-latm_000000001180bc60: CMD = pcm -i $(TARGET_SAMPLES)/aac/latm_000000001180bc60.mpg
 fate-aac-latm_000000001180bc60: REF = $(SAMPLES)/aac/latm_000000001180bc60.s16
@@ -262,7 +270,10 @@ FATE_AAC_ENCODE-$(call ENCMUX, AAC, ADTS) += $(FATE_AAC_ENCODE)
 
 FATE_AAC_BSF-$(call ALLYES, AAC_DEMUXER AAC_ADTSTOASC_BSF MATROSKA_MUXER) += fate-aac-autobsf-adtstoasc
 
+FATE_AAC_THREADS-$(call FILTERDEMDECENCMUX, PAN, WAV, PCM_S16LE, AAC, FRAMECRC) += $(FATE_AAC_THREADS)
+
 FATE_SAMPLES_FFMPEG += $(FATE_AAC_ALL) $(FATE_AAC_ENCODE-yes) $(FATE_AAC_BSF-yes)
+FATE_FFMPEG += $(FATE_AAC_THREADS-yes)
 
-fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes)
+fate-aac: $(FATE_AAC_ALL) $(FATE_AAC_ENCODE) $(FATE_AAC_BSF-yes) $(FATE_AAC_THREADS-yes)
 fate-aac-latm: $(FATE_AAC_LATM-yes)
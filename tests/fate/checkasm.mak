@@ -1,4 +1,5 @@
-FATE_CHECKASM = fate-checkasm-alacdsp                                   \
+FATE_CHECKASM = fate-checkasm-aacencdsp                                 \
+                fate-checkasm-alacdsp                                   \
                 fate-checkasm-audiodsp                                  \
                 fate-checkasm-blockdsp                                  \
                 fate-checkasm-bswapdsp                                  \
@@ -13,7 +14,10 @@ FATE_CHECKASM = fate-checkasm-alacdsp                                   \
                 fate-checkasm-hevc_idct                                 \
                 fate-checkasm-jpeg2000dsp                               \
                 fate-checkasm-llviddsp                                  \
+                fate-checkasm-lpc                                       \
                 fate-checkasm-pixblockdsp                               \
+                fate-checkasm-pngdsp                                    \
+                fate-checkasm-sw_scale                                  \
                 fate-checkasm-synth_filter                              \
                 fate-checkasm-v210enc                                   \
                 fate-checkasm-vf_blend                                  \
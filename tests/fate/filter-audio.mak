@@ -152,6 +152,13 @@ FATE_AFILTER-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FIL
 fate-filter-hls: tests/data/hls-list.m3u8
 fate-filter-hls: CMD = framecrc -flags +bitexact -i $(TARGET_PATH)/tests/data/hls-list.m3u8
 
+# Seeking restarts the segment prefetching, the output must not depend on it.
+FATE_HLS_SEEK = fate-filter-hls-seek-prefetch-0 fate-filter-hls-seek-prefetch-2
+FATE_AFILTER-$(call ALLYES, HLS_DEMUXER MPEGTS_MUXER MPEGTS_DEMUXER AEVALSRC_FILTER LAVFI_INDEV MP2FIXED_ENCODER) += $(FATE_HLS_SEEK)
+$(FATE_HLS_SEEK): tests/data/hls-list.m3u8
+$(FATE_HLS_SEEK): REF = $(SRC_PATH)/tests/ref/fate/filter-hls-seek
+fate-filter-hls-seek-prefetch-%: CMD = framecrc -flags +bitexact -prefetch $(@:fate-filter-hls-seek-prefetch-%=%) -ss 12 -i $(TARGET_PATH)/tests/data/hls-list.m3u8
+
 tests/data/hls-list-append.m3u8: TAG = GEN
 tests/data/hls-list-append.m3u8: ffmpeg$(PROGSSUF)$(EXESUF) | tests/data
 	$(M)$(TARGET_EXEC) $(TARGET_PATH)/$< \
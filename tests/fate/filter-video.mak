@@ -89,6 +89,15 @@ FATE_FILTER-$(call ALLYES, FRAMERATE_FILTER TESTSRC2_FILTER) += fate-filter-fram
 fate-filter-framerate-up: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=10 -t 1
 fate-filter-framerate-down: CMD = framecrc -lavfi testsrc2=r=2:d=10,framerate=fps=1 -t 1
 
+# The branches after split run concurrently with frame threads, the output
+# must be the same as with slice threads only.
+FATE_FILTER_THREADS = fate-filter-threads-slice fate-filter-threads-frame
+FATE_FILTER-$(call ALLYES, TESTSRC2_FILTER SPLIT_FILTER HFLIP_FILTER BOXBLUR_FILTER SCALE_FILTER UNSHARP_FILTER) += $(FATE_FILTER_THREADS)
+$(FATE_FILTER_THREADS): REF = $(SRC_PATH)/tests/ref/fate/filter-threads
+fate-filter-threads-slice: FILTER_THREAD_TYPE = slice
+fate-filter-threads-frame: FILTER_THREAD_TYPE = slice+frame
+fate-filter-threads-%: CMD = framecrc -filter_thread_type $(FILTER_THREAD_TYPE) -filter_complex_threads 4 -lavfi "testsrc2=r=7:d=2,split[a][b];[a]hflip=thread_type=slice+frame,boxblur=thread_type=slice+frame:2:1[a1];[b]scale=thread_type=slice+frame:w=160:h=120,unsharp=thread_type=slice+frame[b1]" -map "[a1]" -map "[b1]"
+
 FATE_FILTER_VSYNTH-$(CONFIG_BOXBLUR_FILTER) += fate-filter-boxblur
 fate-filter-boxblur: CMD = framecrc -c:v pgmyuv -i $(SRC) -vf boxblur=2:1
 